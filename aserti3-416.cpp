@@ -3,8 +3,10 @@
 #include <cstdint>
 #include <cstring>
 
+#include <algorithm>
 #include <iostream>
 #include <string>
+#include <type_traits>
 
 #include "aserti3-416.hpp"
 
@@ -14,8 +16,7 @@ uint32_t arith_uint256::GetCompact(bool fNegative) const {
     if (nSize <= 3) {
         nCompact = GetLow64() << 8 * (3 - nSize);
     } else {
-        arith_uint256 bn = *this >> 8 * (nSize - 3);
-        nCompact = bn.GetLow64();
+        nCompact = GetLow64Shifted(8 * (nSize - 3));
     }
     // The 0x00800000 bit denotes the sign.
     // Thus, if it is already set, divide the mantissa by 256 and increase the
@@ -31,8 +32,15 @@ uint32_t arith_uint256::GetCompact(bool fNegative) const {
     return nCompact;
 }
 
-// This implementation directly uses shifts instead of going through an
-// intermediate MPI representation.
+void GetCompactBatch(const arith_uint256 *targets, size_t count,
+                     uint32_t *nBitsOut) noexcept {
+    for (size_t i = 0; i < count; ++i) {
+        nBitsOut[i] = targets[i].GetCompact();
+    }
+}
+
+// This implementation directly places the mantissa instead of going through
+// an intermediate MPI representation.
 arith_uint256 &arith_uint256::SetCompact(uint32_t nCompact, bool *pfNegative,
                                          bool *pfOverflow) {
     int nSize = nCompact >> 24;
@@ -41,8 +49,7 @@ arith_uint256 &arith_uint256::SetCompact(uint32_t nCompact, bool *pfNegative,
         nWord >>= 8 * (3 - nSize);
         *this = nWord;
     } else {
-        *this = nWord;
-        *this <<= 8 * (nSize - 3);
+        SetLow64Shifted(nWord, 8 * (nSize - 3));
     }
     if (pfNegative) {
         *pfNegative = nWord != 0 && (nCompact & 0x00800000) != 0;
@@ -61,58 +68,61 @@ arith_uint256 &arith_uint256::SetCompact(uint32_t nCompact, bool *pfNegative,
 //     return little_endian_32bits;
 // }
 
-static inline uint32_t ReadLE32(const uint8_t *ptr) {
-    uint32_t x;
-    memcpy((char *)&x, ptr, 4);
-    return le32toh(x);
+uint256 ArithToUint256(const arith_uint256 &a) {
+    uint256 b;
+    for (int x = 0; x < a.WIDTH; ++x) {
+#if BASE_UINT_LIMB_BITS == 64
+        WriteLE64(b.begin() + x * 8, a.pn[x]);
+#else
+        WriteLE32(b.begin() + x * 4, a.pn[x]);
+#endif
+    }
+    return b;
 }
 
 arith_uint256 UintToArith256(const uint256 &a) {
     arith_uint256 b;
     for (int x = 0; x < b.WIDTH; ++x) {
+#if BASE_UINT_LIMB_BITS == 64
+        b.pn[x] = ReadLE64(a.begin() + x * 8);
+#else
         b.pn[x] = ReadLE32(a.begin() + x * 4);
+#endif
     }
     return b;
 }
 
 
 
-// https://gitlab.com/freetrader/bitcoin-cash-node/-/blob/affe4657dc85f25b6782648960579bb2a8fedd6a/src/pow.cpp#L106
-// ASERT calculation function.
-// Clamps to powLimit.
-arith_uint256 CalculateASERT(const arith_uint256 refTarget,
-                             const int64_t nPowTargetSpacing,
-                             const int64_t nTimeDiff,
-                             const int64_t nHeightDiff,
-                             const arith_uint256 powLimit,
-                             const int64_t nHalfLife,
-                             bool debugASERT) noexcept {
-
-    // std::cout << "CalculateASERT - 1\n";
-
-
-    // Input target must never be zero nor exceed powLimit.
-    assert(refTarget > 0 && refTarget <= powLimit);
+namespace {
 
-    // std::cout << "CalculateASERT - 2\n";
+// Coefficient c of the rbits = 16 cubic rescaled for nRBits: c * 2^shift,
+// rounded to nearest when shift is negative.
+template <typename T>
+constexpr T ScaleCoefficient(uint64_t c, int shift) {
+    return shift >= 0 ? T(c) << shift : T((c + (uint64_t(1) << (-shift - 1))) >> -shift);
+}
 
-    // Height diff should NOT be negative.
-    assert(nHeightDiff >= 0);
-    // std::cout << "CalculateASERT - 3\n";
+} // namespace
 
+// https://gitlab.com/freetrader/bitcoin-cash-node/-/blob/affe4657dc85f25b6782648960579bb2a8fedd6a/src/pow.cpp#L106
+// First half of CalculateASERTi: everything that only depends on the time and
+// height differences, i.e. plain 64-bit integer work that does not involve
+// the target.
+template <int nOrder, int nRBits>
+void CalculateASERTiShiftsAndFactor(const int64_t nPowTargetSpacing,
+                                    const int64_t nTimeDiff,
+                                    const int64_t nHeightDiff,
+                                    const int64_t nHalfLife,
+                                    int64_t &shifts,
+                                    uint64_t &factor) noexcept {
 
     // This algorithm uses fixed-point math. The lowest rbits bits are after
     // the radix, and represent the "decimal" (or binary) portion of the value
-    constexpr uint8_t rbits = 16;
-    static_assert(rbits > 0);
-
-    arith_uint256 nextTarget = refTarget;
-
-    // std::cout << "refTarget.GetCompact():         " << refTarget.GetCompact() << "\n";
-    // std::cout << "nextTarget.GetCompact():        " << nextTarget.GetCompact() << "\n";
-
-    // It will be helpful when reading what follows, to remember that
-    // nextTarget is adapted from reference block target value.
+    constexpr int rbits = nRBits;
+    static_assert(rbits > 0 && rbits < 32);
+    static_assert(nOrder >= 1 && nOrder <= 3, "2^x is approximated by a polynomial of degree 1, 2 or 3");
+    constexpr int64_t radix = int64_t(1) << rbits;
 
     // Ultimately, we want to approximate the following ASERT formula, using only integer (fixed-point) math:
     //     new_target = old_target * 2^((blocks_time - IDEAL_BLOCK_TIME*(height_diff+1)) / nHalfLife)
@@ -120,14 +130,9 @@ arith_uint256 CalculateASERT(const arith_uint256 refTarget,
     // First, we'll calculate the exponent:
     assert( abs(nTimeDiff - nPowTargetSpacing * nHeightDiff) < (1ull<<(63-rbits)) );
 
-    // std::cout << "nTimeDiff:         " << nTimeDiff << "\n";
-    // std::cout << "nPowTargetSpacing: " << nPowTargetSpacing << "\n";
-    // std::cout << "nHeightDiff:       " << nHeightDiff << "\n";
-    // std::cout << "rbits:             " << (int)rbits << "\n";
-    // std::cout << "nHalfLife:         " << nHalfLife << "\n";
-
+    // Truncated, as in BCHN: mining.py's // floors, so for negative exponents
+    // the aserti* variants are not bit-identical to their Python namesakes.
     int64_t exponent = ((nTimeDiff - nPowTargetSpacing * nHeightDiff) << rbits) / nHalfLife;
-    // std::cout << "exponent:         " << exponent << "\n";
 
     // Next, we use the 2^x = 2 * 2^(x-1) identity to shift our exponent into the [0, 1) interval.
     // The truncated exponent tells us how many shifts we need to do
@@ -140,67 +145,127 @@ arith_uint256 CalculateASERT(const arith_uint256 refTarget,
     static_assert(int64_t(-1) >> 1 == int64_t(-1),
                   "ASERT algorithm needs arithmetic shift support");
 
-    const int64_t shifts = exponent >> rbits;
-    // std::cout << "shifts:         " << shifts << "\n";
+    shifts = exponent >> rbits;
+
+    // Remove everything but the decimal part from the exponent since we've
+    // accounted for that through shifting.
+    exponent -= (shifts << rbits);
+    // What is left then should now be in the fixed point range [0, 1).
+    assert(exponent >= 0 && exponent < radix);
+
+    if constexpr (nOrder == 1) {
+        // 2^x ~= 1 + x
+        factor = uint64_t(exponent);
+    } else if constexpr (nOrder == 2) {
+        // 2^x ~= 1 + 2*x/3 + x**2/3, with 2 * rbits bits after the radix.
+        const uint64_t e = uint64_t(exponent);
+        factor = (2 * e * radix + e * e) / 3;
+    } else {
+        // 2^x ~= (1 + 0.695502049*x + 0.2262698*x**2 + 0.0782318*x**3) for 0 <= x < 1
+        // Error versus actual 2^x is less than 0.013%.
+        // The sum needs 4 * rbits bits: 64-bit arithmetic up to rbits = 16.
+        using Wide = std::conditional_t<(4 * rbits <= 64), uint64_t, unsigned __int128>;
+        const Wide e = Wide(exponent);
+        factor = uint64_t((ScaleCoefficient<Wide>(195766423245049, 3 * (rbits - 16)) * e +
+                           ScaleCoefficient<Wide>(971821376, 2 * (rbits - 16)) * e * e +
+                           ScaleCoefficient<Wide>(5127, rbits - 16) * e * e * e +
+                           (Wide(1) << (3 * rbits - 1))) >> (rbits * 3));
+    }
+}
+
+// Second half of CalculateASERTi: applies the shifts and factor computed by
+// CalculateASERTiShiftsAndFactor() to the reference target.
+// Clamps to powLimit.
+template <int nFactorBits>
+arith_uint256 ApplyASERTiShiftsAndFactor(const arith_uint256 &refTarget,
+                                         const int64_t shifts,
+                                         const uint64_t factor,
+                                         const arith_uint256 &powLimit) noexcept {
+
+    constexpr uint8_t rbits = nFactorBits;
+
+    // It will be helpful when reading what follows, to remember that
+    // nextTarget is adapted from reference block target value.
+    arith_uint256 nextTarget = refTarget;
 
     if (shifts < 0) {
-        // std::cout << "CalculateASERT - 4\n";
         nextTarget = nextTarget >> -shifts;
     } else {
-        // std::cout << "CalculateASERT - 5\n";
         nextTarget = nextTarget << shifts;
     }
-    // std::cout << "CalculateASERT - 6\n";
-    // std::cout << "nextTarget.GetCompact():        " << nextTarget.GetCompact() << "\n";
-
-    // Remove everything but the decimal part from the exponent since we've
-    // accounted for that through shifting.
-    exponent -= (shifts << rbits);
-    // What is left then should now be in the fixed point range [0, 1).
-    assert(exponent >= 0 && exponent < 65536);
-    // std::cout << "exponent:         " << exponent << "\n";
 
     // Check for overflow and underflow from shifting nextTarget. Since it's a uint, both could result in a
     // value of 0, so we'll need to clamp it if so. We can figure out which happened by looking at shifts's sign.
     if (nextTarget == 0 || nextTarget > powLimit) {
-        // std::cout << "CalculateASERT - 7\n";
         if (shifts < 0) {
-            // std::cout << "CalculateASERT - 8\n";
-            // std::cout << "returns:  1\n";
             return arith_uint256(1);
         } else {
-            // std::cout << "CalculateASERT - 9\n";
-            // std::cout << "returns powLimit.GetCompact():        " << powLimit.GetCompact() << "\n";
             return powLimit;
         }
     }
-    // std::cout << "CalculateASERT - 10\n";
 
     // Now we compute an approximated target * 2^(exponent)
-
-    // 2^x ~= (1 + 0.695502049*x + 0.2262698*x**2 + 0.0782318*x**3) for 0 <= x < 1
-    // Error versus actual 2^x is less than 0.013%.
-    uint64_t factor = (195766423245049*exponent +
-                       971821376*exponent*exponent +
-                       5127*exponent*exponent*exponent + (1ull<<47))>>(rbits*3);
-
-    // std::cout << "factor:         " << factor << "\n";
-
-    nextTarget += (nextTarget * factor) >> rbits;
-    // std::cout << "nextTarget.GetCompact():        " << nextTarget.GetCompact() << "\n";
+    arith_uint256 increment = nextTarget;
+    increment.MulU64ShiftRight(factor, rbits);
+    nextTarget += increment;
 
     // The last operation was strictly increasing, so it could have exceeded powLimit. Check and clamp again.
     if (nextTarget > powLimit) {
-        // std::cout << "CalculateASERT - 11\n";
-        // std::cout << "returns powLimit.GetCompact():        " << powLimit.GetCompact() << "\n";
         return powLimit;
     }
-    // std::cout << "CalculateASERT - 12\n";
 
-    // std::cout << "returns nextTarget.GetCompact():        " << nextTarget.GetCompact() << "\n";
     return nextTarget;
 }
 
+// https://gitlab.com/freetrader/bitcoin-cash-node/-/blob/affe4657dc85f25b6782648960579bb2a8fedd6a/src/pow.cpp#L106
+// ASERT calculation function.
+// Clamps to powLimit.
+template <int nOrder, int nRBits>
+arith_uint256 CalculateASERTi(const arith_uint256 refTarget,
+                              const int64_t nPowTargetSpacing,
+                              const int64_t nTimeDiff,
+                              const int64_t nHeightDiff,
+                              const arith_uint256 powLimit,
+                              const int64_t nHalfLife) noexcept {
+
+    // Input target must never be zero nor exceed powLimit.
+    assert(refTarget > 0 && refTarget <= powLimit);
+
+    // Height diff should NOT be negative.
+    assert(nHeightDiff >= 0);
+
+    int64_t shifts;
+    uint64_t factor;
+    CalculateASERTiShiftsAndFactor<nOrder, nRBits>(nPowTargetSpacing, nTimeDiff, nHeightDiff, nHalfLife, shifts, factor);
+    return ApplyASERTiShiftsAndFactor<ASERTiFactorBits<nOrder, nRBits>>(refTarget, shifts, factor, powLimit);
+}
+
+void CalculateASERTShiftsAndFactor(const int64_t nPowTargetSpacing,
+                                   const int64_t nTimeDiff,
+                                   const int64_t nHeightDiff,
+                                   const int64_t nHalfLife,
+                                   int64_t &shifts,
+                                   uint64_t &factor) noexcept {
+    CalculateASERTiShiftsAndFactor<3, 16>(nPowTargetSpacing, nTimeDiff, nHeightDiff, nHalfLife, shifts, factor);
+}
+
+arith_uint256 ApplyASERTShiftsAndFactor(const arith_uint256 &refTarget,
+                                        const int64_t shifts,
+                                        const uint64_t factor,
+                                        const arith_uint256 &powLimit) noexcept {
+    return ApplyASERTiShiftsAndFactor<16>(refTarget, shifts, factor, powLimit);
+}
+
+arith_uint256 CalculateASERT(const arith_uint256 refTarget,
+                             const int64_t nPowTargetSpacing,
+                             const int64_t nTimeDiff,
+                             const int64_t nHeightDiff,
+                             const arith_uint256 powLimit,
+                             const int64_t nHalfLife,
+                             bool debugASERT) noexcept {
+    return CalculateASERTi<3, 16>(refTarget, nPowTargetSpacing, nTimeDiff, nHeightDiff, powLimit, nHalfLife);
+}
+
 
 // https://gitlab.com/freetrader/bitcoin-cash-node/-/blob/affe4657dc85f25b6782648960579bb2a8fedd6a/src/pow.cpp#L52
 /**
@@ -274,7 +339,11 @@ uint32_t GetNextASERTWorkRequired(const CBlockIndex *pindexPrev,
     const arith_uint256 refBlockTarget = arith_uint256().SetCompact(pindexReferenceBlock->nBits);
     // std::cout << "refBlockTarget.GetCompact(): " << refBlockTarget.GetCompact() << "\n";
 
-    static const arith_uint256 powLimit = UintToArith256(params.powLimit);
+    // Converted on every call: this is only a few word loads, and a
+    // function-local static would pin the powLimit of whichever params came
+    // first (and pay a guard check per call). Callers evaluating many blocks
+    // against the same params should use ASERTContext, which caches it.
+    const arith_uint256 powLimit = UintToArith256(params.powLimit);
     // std::cout << "powLimit.GetCompact(): " << powLimit.GetCompact() << "\n";
 
     // Refactored: do the actual target adaptation calculation in separate
@@ -293,6 +362,358 @@ uint32_t GetNextASERTWorkRequired(const CBlockIndex *pindexPrev,
     return nextTarget.GetCompact();
 }
 
+arith_uint256 GetBlockProof(uint32_t nBits) {
+    arith_uint256 bnTarget;
+    bool fNegative;
+    bool fOverflow;
+    bnTarget.SetCompact(nBits, &fNegative, &fOverflow);
+    if (fNegative || fOverflow || bnTarget == arith_uint256()) {
+        return arith_uint256();
+    }
+    // We need to compute 2**256 / (bnTarget+1), but we can't represent 2**256
+    // as it's too large for an arith_uint256. However, as 2**256 is at least as
+    // large as bnTarget+1, it is equal to ((2**256 - bnTarget - 1) /
+    // (bnTarget+1)) + 1, or ~bnTarget / (bnTarget+1) + 1.
+    arith_uint256 bnTargetPlusOne = bnTarget;
+    ++bnTargetPlusOne;
+    arith_uint256 proof = ~bnTarget / bnTargetPlusOne;
+    return ++proof;
+}
+
+uint32_t GetNextASERTWorkRequired(const CChainStore &chain,
+                                  int nPrevHeight,
+                                  int nRefHeight,
+                                  const Consensus::Params &params) noexcept {
+    assert(chain.Contains(nPrevHeight) && chain.Contains(nRefHeight));
+    assert(nPrevHeight >= nRefHeight);
+
+    if (nPrevHeight == nRefHeight) {
+        return chain.GetBits(nRefHeight);
+    }
+
+    const arith_uint256 refBlockTarget = arith_uint256().SetCompact(chain.GetBits(nRefHeight));
+    const arith_uint256 powLimit = UintToArith256(params.powLimit);
+    return CalculateASERT(refBlockTarget,
+                          params.nPowTargetSpacing,
+                          chain.GetBlockTime(nPrevHeight) - chain.GetBlockTime(nRefHeight),
+                          int64_t(nPrevHeight) - nRefHeight,
+                          powLimit,
+                          params.nDAAHalfLife,
+                          false).GetCompact();
+}
+
+void GetNextASERTWorkRequiredRange(const CChainStore &chain,
+                                   int nRefHeight,
+                                   int nFirstPrevHeight,
+                                   size_t count,
+                                   const Consensus::Params &params,
+                                   uint32_t *nBitsOut) noexcept {
+    if (count == 0) {
+        return;
+    }
+    assert(chain.Contains(nRefHeight) && nFirstPrevHeight >= nRefHeight);
+    assert(chain.Contains(nFirstPrevHeight + int(count) - 1));
+
+    const int64_t nRefTime = chain.GetBlockTime(nRefHeight);
+    const uint32_t *times = chain.Times() + (nFirstPrevHeight - chain.FirstHeight());
+
+    constexpr size_t chunkSize = 256;
+    int64_t nTimeDiffs[chunkSize];
+    int64_t nHeightDiffs[chunkSize];
+
+    for (size_t begin = 0; begin < count; begin += chunkSize) {
+        const size_t n = std::min(chunkSize, count - begin);
+        for (size_t i = 0; i < n; ++i) {
+            nTimeDiffs[i] = int64_t(times[begin + i]) - nRefTime;
+            nHeightDiffs[i] = int64_t(nFirstPrevHeight - nRefHeight) + int64_t(begin + i);
+        }
+        CalculateASERTBatch(chain.GetBits(nRefHeight), nTimeDiffs, nHeightDiffs, n, params, nBitsOut + begin);
+    }
+}
+
+// Same sorting network as BCHN's GetSuitableBlock.
+const CBlockIndex *GetSuitableBlock(const CBlockIndex *pindex) noexcept {
+    assert(pindex->pprev != nullptr && pindex->pprev->pprev != nullptr);
+    const CBlockIndex *blocks[3];
+    blocks[2] = pindex;
+    blocks[1] = pindex->pprev;
+    blocks[0] = blocks[1]->pprev;
+
+    if (blocks[0]->nTime > blocks[2]->nTime) {
+        std::swap(blocks[0], blocks[2]);
+    }
+    if (blocks[0]->nTime > blocks[1]->nTime) {
+        std::swap(blocks[0], blocks[1]);
+    }
+    if (blocks[1]->nTime > blocks[2]->nTime) {
+        std::swap(blocks[1], blocks[2]);
+    }
+    return blocks[1];
+}
+
+int GetSuitableBlockHeight(const CChainStore &chain, int nHeight) noexcept {
+    assert(chain.Contains(nHeight - 2) && chain.Contains(nHeight));
+    int heights[3] = {nHeight - 2, nHeight - 1, nHeight};
+
+    if (chain.GetTime(heights[0]) > chain.GetTime(heights[2])) {
+        std::swap(heights[0], heights[2]);
+    }
+    if (chain.GetTime(heights[0]) > chain.GetTime(heights[1])) {
+        std::swap(heights[0], heights[1]);
+    }
+    if (chain.GetTime(heights[1]) > chain.GetTime(heights[2])) {
+        std::swap(heights[1], heights[2]);
+    }
+    return heights[1];
+}
+
+uint32_t GetNextASERTMo3WorkRequired(const CBlockIndex *pindexPrev,
+                                     const CBlockHeader *pblock,
+                                     const Consensus::Params &params,
+                                     const CBlockIndex *pindexAnchor,
+                                     bool debugASERT) noexcept {
+    assert(pindexPrev != nullptr && pindexAnchor != nullptr);
+    assert(pindexPrev->nHeight >= pindexAnchor->nHeight);
+
+    // Special difficulty rule for testnet, as in GetNextASERTWorkRequired.
+    if (params.fPowAllowMinDifficultyBlocks &&
+        (pblock->GetBlockTime() >
+         pindexPrev->GetBlockTime() + 2 * params.nPowTargetSpacing)) {
+        return UintToArith256(params.powLimit).GetCompact();
+    }
+
+    const CBlockIndex *pindexLast = GetSuitableBlock(pindexPrev);
+    const CBlockIndex *pindexFirst = GetSuitableBlock(pindexAnchor);
+    if (pindexLast->nHeight <= pindexFirst->nHeight) {
+        return pindexFirst->nBits;
+    }
+
+    const arith_uint256 refBlockTarget = arith_uint256().SetCompact(pindexFirst->nBits);
+    const arith_uint256 powLimit = UintToArith256(params.powLimit);
+    return CalculateASERT(refBlockTarget,
+                          params.nPowTargetSpacing,
+                          pindexLast->GetBlockTime() - pindexFirst->GetBlockTime(),
+                          int64_t(pindexLast->nHeight) - pindexFirst->nHeight,
+                          powLimit,
+                          params.nDAAHalfLife,
+                          debugASERT).GetCompact();
+}
+
+uint32_t GetNextASERTMo3WorkRequired(const CChainStore &chain,
+                                     int nPrevHeight,
+                                     int nAnchorHeight,
+                                     const Consensus::Params &params) noexcept {
+    assert(nPrevHeight >= nAnchorHeight);
+
+    const int nLastHeight = GetSuitableBlockHeight(chain, nPrevHeight);
+    const int nFirstHeight = GetSuitableBlockHeight(chain, nAnchorHeight);
+    if (nLastHeight <= nFirstHeight) {
+        return chain.GetBits(nFirstHeight);
+    }
+
+    const arith_uint256 refBlockTarget = arith_uint256().SetCompact(chain.GetBits(nFirstHeight));
+    const arith_uint256 powLimit = UintToArith256(params.powLimit);
+    return CalculateASERT(refBlockTarget,
+                          params.nPowTargetSpacing,
+                          chain.GetBlockTime(nLastHeight) - chain.GetBlockTime(nFirstHeight),
+                          int64_t(nLastHeight) - nFirstHeight,
+                          powLimit,
+                          params.nDAAHalfLife,
+                          false).GetCompact();
+}
+
+namespace {
+
+// tau = int(math.log(2) * IDEAL_BLOCK_TIME * N) for aserti<order>-<N>.
+const struct {
+    const char *name;
+    ASERTiVariant variant;
+} variants[] = {
+    {"aserti1-144", {1, 59887, false}},
+    {"aserti1-288", {1, 119775, false}},
+    {"aserti1-576", {1, 239551, false}},
+    {"aserti2-144", {2, 59887, false}},
+    {"aserti2-288", {2, 119775, false}},
+    {"aserti2-576", {2, 239551, false}},
+    {"aserti3-072", {3, 29943, false}},
+    {"aserti3-144", {3, 59887, false}},
+    {"aserti3-200", {3, 83177, false}},
+    {"aserti3-208", {3, 86504, false}},
+    {"aserti3-288", {3, 119775, false}},
+    {"aserti3-416", {3, 173009, false}},
+    {"aserti3-576", {3, 239551, false}},
+    {"aserti3-mo3-072", {3, 29943, true}},
+    {"aserti3-mo3-144", {3, 59887, true}},
+    {"aserti3-mo3-200", {3, 83177, true}},
+    {"aserti3-mo3-208", {3, 86504, true}},
+    {"aserti3-mo3-288", {3, 119775, true}},
+    {"aserti3-mo3-416", {3, 173009, true}},
+    {"aserti3-mo3-576", {3, 239551, true}},
+    {"aserti3-416-cpp", {3, 0, false}},
+    {"aserti3-mo3-416-cpp", {3, 0, true}},
+};
+
+} // namespace
+
+bool GetASERTiVariant(const std::string &name, ASERTiVariant &variant) {
+    for (const auto &entry : variants) {
+        if (name == entry.name) {
+            variant = entry.variant;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::vector<std::string> GetASERTiVariantNames() {
+    std::vector<std::string> names;
+    for (const auto &entry : variants) {
+        names.push_back(entry.name);
+    }
+    return names;
+}
+
+uint32_t GetNextASERTiWorkRequired(const ASERTiVariant &variant,
+                                   const CChainStore &chain,
+                                   int nPrevHeight,
+                                   int nAnchorHeight,
+                                   const Consensus::Params &params) noexcept {
+    assert(nPrevHeight >= nAnchorHeight);
+
+    int nLastHeight = nPrevHeight;
+    int nFirstHeight = nAnchorHeight;
+    if (variant.fMedianOfThree) {
+        nLastHeight = GetSuitableBlockHeight(chain, nPrevHeight);
+        nFirstHeight = GetSuitableBlockHeight(chain, nAnchorHeight);
+    }
+    if (nLastHeight <= nFirstHeight) {
+        return chain.GetBits(nFirstHeight);
+    }
+
+    const arith_uint256 refBlockTarget = arith_uint256().SetCompact(chain.GetBits(nFirstHeight));
+    const arith_uint256 powLimit = UintToArith256(params.powLimit);
+    const int64_t nTimeDiff = chain.GetBlockTime(nLastHeight) - chain.GetBlockTime(nFirstHeight);
+    const int64_t nHeightDiff = int64_t(nLastHeight) - nFirstHeight;
+    const int64_t nHalfLife = variant.nHalfLife != 0 ? variant.nHalfLife : params.nDAAHalfLife;
+
+    switch (variant.nOrder) {
+    case 1:
+        return CalculateASERTi<1, 16>(refBlockTarget, params.nPowTargetSpacing, nTimeDiff, nHeightDiff,
+                                      powLimit, nHalfLife).GetCompact();
+    case 2:
+        return CalculateASERTi<2, 16>(refBlockTarget, params.nPowTargetSpacing, nTimeDiff, nHeightDiff,
+                                      powLimit, nHalfLife).GetCompact();
+    default:
+        assert(variant.nOrder == 3);
+        return CalculateASERTi<3, 16>(refBlockTarget, params.nPowTargetSpacing, nTimeDiff, nHeightDiff,
+                                      powLimit, nHalfLife).GetCompact();
+    }
+}
+
+ASERTContext::ASERTContext(const CBlockIndex &referenceBlock,
+                           const Consensus::Params &params)
+    : ASERTContext(referenceBlock.nHeight, referenceBlock.GetBlockTime(),
+                   referenceBlock.nBits, params)
+{}
+
+ASERTContext::ASERTContext(int nRefHeight, int64_t nRefTime, uint32_t nRefBits,
+                           const Consensus::Params &params)
+    : nRefHeight(nRefHeight)
+    , nRefTime(nRefTime)
+    , nRefBits(nRefBits)
+    , refTarget(arith_uint256().SetCompact(nRefBits))
+    , powLimit(UintToArith256(params.powLimit))
+    , nPowTargetSpacing(params.nPowTargetSpacing)
+    , nHalfLife(params.nDAAHalfLife)
+{
+    // Input target must never be zero nor exceed powLimit.
+    assert(refTarget > 0 && refTarget <= powLimit);
+}
+
+uint32_t ASERTContext::next(int64_t nTipTime, int nTipHeight) const noexcept {
+    return next<3, 16>(nTipTime, nTipHeight);
+}
+
+template <int nOrder, int nRBits>
+uint32_t ASERTContext::next(int64_t nTipTime, int nTipHeight) const noexcept {
+    // We make no further assumptions other than the height of the prev block must be >= that of the reference block.
+    assert(nTipHeight >= nRefHeight);
+
+    // Same shortcut as GetNextASERTWorkRequired.
+    if (nTipHeight == nRefHeight) {
+        return nRefBits;
+    }
+
+    int64_t shifts;
+    uint64_t factor;
+    CalculateASERTiShiftsAndFactor<nOrder, nRBits>(nPowTargetSpacing, nTipTime - nRefTime,
+                                                   int64_t(nTipHeight) - nRefHeight, nHalfLife, shifts, factor);
+    return ApplyASERTiShiftsAndFactor<ASERTiFactorBits<nOrder, nRBits>>(refTarget, shifts, factor, powLimit)
+        .GetCompact();
+}
+
+// One instantiation per approximation used by mining.py's Algos.
+#define ASERTI_INSTANTIATE(nOrder, nRBits)                                                          \
+    template void CalculateASERTiShiftsAndFactor<nOrder, nRBits>(int64_t, int64_t, int64_t, int64_t, \
+                                                                 int64_t &, uint64_t &) noexcept;   \
+    template arith_uint256 CalculateASERTi<nOrder, nRBits>(arith_uint256, int64_t, int64_t, int64_t, \
+                                                           arith_uint256, int64_t) noexcept;        \
+    template uint32_t ASERTContext::next<nOrder, nRBits>(int64_t, int) const noexcept;
+
+ASERTI_INSTANTIATE(1, 16)
+ASERTI_INSTANTIATE(2, 16)
+ASERTI_INSTANTIATE(3, 16)
+
+#undef ASERTI_INSTANTIATE
+
+template arith_uint256 ApplyASERTiShiftsAndFactor<16>(const arith_uint256 &, int64_t, uint64_t,
+                                                      const arith_uint256 &) noexcept;
+template arith_uint256 ApplyASERTiShiftsAndFactor<32>(const arith_uint256 &, int64_t, uint64_t,
+                                                      const arith_uint256 &) noexcept;
+
+void CalculateASERTBatch(uint32_t nRefBits,
+                         const int64_t *nTimeDiffs,
+                         const int64_t *nHeightDiffs,
+                         size_t count,
+                         const Consensus::Params &params,
+                         uint32_t *nBitsOut) noexcept {
+
+    const arith_uint256 refBlockTarget = arith_uint256().SetCompact(nRefBits);
+    const arith_uint256 powLimit = UintToArith256(params.powLimit);
+
+    // Input target must never be zero nor exceed powLimit.
+    assert(refBlockTarget > 0 && refBlockTarget <= powLimit);
+
+    // The 64-bit part is vectorized chunk by chunk, the 256-bit part is not.
+    constexpr size_t chunkSize = 256;
+    int64_t shifts[chunkSize];
+    uint64_t factors[chunkSize];
+
+    for (size_t begin = 0; begin < count; begin += chunkSize) {
+        const size_t n = std::min(chunkSize, count - begin);
+        CalculateASERTShiftsAndFactors(params.nPowTargetSpacing,
+                                       params.nDAAHalfLife,
+                                       nTimeDiffs + begin,
+                                       nHeightDiffs + begin,
+                                       n,
+                                       shifts,
+                                       factors);
+
+        for (size_t i = 0; i < n; ++i) {
+            // Height diff should NOT be negative.
+            assert(nHeightDiffs[begin + i] >= 0);
+
+            // Same shortcut as GetNextASERTWorkRequired: the block right after
+            // the reference one keeps its target.
+            if (nHeightDiffs[begin + i] == 0) {
+                nBitsOut[begin + i] = nRefBits;
+                continue;
+            }
+            nBitsOut[begin + i] = ApplyASERTShiftsAndFactor(refBlockTarget, shifts[i], factors[i], powLimit).GetCompact();
+        }
+    }
+}
+
 
 
 // // https://gitlab.com/jtoomim/bitcoin-cash-node/-/blob/wip-asert/src/pow.cpp#L299
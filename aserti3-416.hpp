@@ -6,6 +6,7 @@
 #include <cstring>
 #include <stdexcept>
 #include <string>
+#include <vector>
 
 /** Template base class for fixed-sized opaque blobs. */
 template <unsigned int BITS> class base_blob {
@@ -245,17 +246,90 @@ inline uint256 uint256S(const std::string &str) {
 
 // ---------------------------------------------------------------------------------------------------
 
+/**
+ * Limb size of base_uint, 32 or 64 bits. Defaults to 64 when the compiler
+ * provides unsigned __int128 to hold the intermediate carries and products.
+ * Both backends produce exactly the same results.
+ */
+#ifndef BASE_UINT_LIMB_BITS
+#if defined(__SIZEOF_INT128__)
+#define BASE_UINT_LIMB_BITS 64
+#else
+#define BASE_UINT_LIMB_BITS 32
+#endif
+#endif
+
+#if BASE_UINT_LIMB_BITS != 32 && BASE_UINT_LIMB_BITS != 64
+#error "BASE_UINT_LIMB_BITS must be 32 or 64"
+#endif
+
+/** Number of leading zero bits of x, which must not be zero. */
+inline int CountLeadingZeros(uint32_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_clz(x);
+#else
+    int n = 0;
+    while ( ! (x & 0x80000000u)) {
+        x <<= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+inline int CountLeadingZeros(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_clzll(x);
+#else
+    return (x >> 32) ? CountLeadingZeros(uint32_t(x >> 32))
+                     : 32 + CountLeadingZeros(uint32_t(x));
+#endif
+}
+
+/**
+ * (hi * 2^32 + lo) / d and its remainder. hi must be lower than d, so that
+ * the quotient fits 32 bits.
+ */
+inline uint32_t DivideLimbs(uint32_t hi, uint32_t lo, uint32_t d, uint32_t &rem) {
+    const uint64_t n = (uint64_t(hi) << 32) | lo;
+    rem = uint32_t(n % d);
+    return uint32_t(n / d);
+}
+
+#if defined(__SIZEOF_INT128__)
+/** The same for 64 bit limbs: a single divq on x86-64. */
+inline uint64_t DivideLimbs(uint64_t hi, uint64_t lo, uint64_t d, uint64_t &rem) {
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+    uint64_t q;
+    __asm__("divq %4" : "=a"(q), "=d"(rem) : "a"(lo), "d"(hi), "rm"(d));
+    return q;
+#else
+    const unsigned __int128 n = ((unsigned __int128)hi << 64) | lo;
+    rem = uint64_t(n % d);
+    return uint64_t(n / d);
+#endif
+}
+#endif
+
 /** Template base class for unsigned big integers. */
 template <unsigned int BITS> class base_uint {
 protected:
-    static constexpr int WIDTH = BITS / 32;
-    uint32_t pn[WIDTH];
+#if BASE_UINT_LIMB_BITS == 64
+    using limb_t = uint64_t;
+    using dlimb_t = unsigned __int128;
+#else
+    using limb_t = uint32_t;
+    using dlimb_t = uint64_t;
+#endif
+    static constexpr int LIMB_BITS = BASE_UINT_LIMB_BITS;
+    static constexpr int WIDTH = BITS / LIMB_BITS;
+    limb_t pn[WIDTH];
 
 public:
     base_uint() {
         static_assert(
-            BITS / 32 > 0 && BITS % 32 == 0,
-            "Template parameter BITS must be a positive multiple of 32.");
+            BITS / 64 > 0 && BITS % 64 == 0,
+            "Template parameter BITS must be a positive multiple of 64.");
 
         for (int i = 0; i < WIDTH; i++) {
             pn[i] = 0;
@@ -264,8 +338,8 @@ public:
 
     base_uint(const base_uint &b) {
         static_assert(
-            BITS / 32 > 0 && BITS % 32 == 0,
-            "Template parameter BITS must be a positive multiple of 32.");
+            BITS / 64 > 0 && BITS % 64 == 0,
+            "Template parameter BITS must be a positive multiple of 64.");
 
         for (int i = 0; i < WIDTH; i++) {
             pn[i] = b.pn[i];
@@ -281,14 +355,10 @@ public:
 
     base_uint(uint64_t b) {
         static_assert(
-            BITS / 32 > 0 && BITS % 32 == 0,
-            "Template parameter BITS must be a positive multiple of 32.");
+            BITS / 64 > 0 && BITS % 64 == 0,
+            "Template parameter BITS must be a positive multiple of 64.");
 
-        pn[0] = (unsigned int)b;
-        pn[1] = (unsigned int)(b >> 32);
-        for (int i = 2; i < WIDTH; i++) {
-            pn[i] = 0;
-        }
+        *this = b;
     }
 
 //     explicit base_uint(const std::string &str);
@@ -313,9 +383,11 @@ public:
 //     double getdouble() const;
 
     base_uint &operator=(uint64_t b) {
-        pn[0] = (unsigned int)b;
-        pn[1] = (unsigned int)(b >> 32);
-        for (int i = 2; i < WIDTH; i++) {
+        constexpr int low = 64 / LIMB_BITS;
+        for (int i = 0; i < low; i++) {
+            pn[i] = limb_t(b >> (i * LIMB_BITS));
+        }
+        for (int i = low; i < WIDTH; i++) {
             pn[i] = 0;
         }
         return *this;
@@ -358,11 +430,11 @@ public:
     base_uint &operator>>=(unsigned int shift);
 
     base_uint &operator+=(const base_uint &b) {
-        uint64_t carry = 0;
+        dlimb_t carry = 0;
         for (int i = 0; i < WIDTH; i++) {
-            uint64_t n = carry + pn[i] + b.pn[i];
-            pn[i] = n & 0xffffffff;
-            carry = n >> 32;
+            dlimb_t n = carry + pn[i] + b.pn[i];
+            pn[i] = limb_t(n);
+            carry = n >> LIMB_BITS;
         }
         return *this;
     }
@@ -387,9 +459,15 @@ public:
 //     }
 
     base_uint &operator*=(uint32_t b32);
-//     base_uint &operator*=(const base_uint &b);
+    base_uint &operator*=(const base_uint &b);
     base_uint &operator/=(const base_uint &b);
 
+    /**
+     * Fused (*this * b64) >> shift in a single pass over the words. The
+     * product is truncated to BITS bits before shifting, as operator*= does.
+     */
+    base_uint &MulU64ShiftRight(uint64_t b64, unsigned int shift);
+
     base_uint &operator++() {
         // prefix operator
         int i = 0;
@@ -433,10 +511,10 @@ public:
 //                                             const base_uint &b) {
 //         return base_uint(a) -= b;
 //     }
-//     friend inline const base_uint operator*(const base_uint &a,
-//                                             const base_uint &b) {
-//         return base_uint(a) *= b;
-//     }
+    friend inline const base_uint operator*(const base_uint &a,
+                                            const base_uint &b) {
+        return base_uint(a) *= b;
+    }
     friend inline const base_uint operator/(const base_uint &a,
                                             const base_uint &b) {
         return base_uint(a) /= b;
@@ -471,15 +549,15 @@ public:
     friend inline bool operator>(const base_uint &a, const base_uint &b) {
         return a.CompareTo(b) > 0;
     }
-//     friend inline bool operator<(const base_uint &a, const base_uint &b) {
-//         return a.CompareTo(b) < 0;
-//     }
+    friend inline bool operator<(const base_uint &a, const base_uint &b) {
+        return a.CompareTo(b) < 0;
+    }
     friend inline bool operator>=(const base_uint &a, const base_uint &b) {
         return a.CompareTo(b) >= 0;
     }
-//     friend inline bool operator<=(const base_uint &a, const base_uint &b) {
-//         return a.CompareTo(b) <= 0;
-//     }
+    friend inline bool operator<=(const base_uint &a, const base_uint &b) {
+        return a.CompareTo(b) <= 0;
+    }
 //     friend inline bool operator==(const base_uint &a, uint64_t b) {
 //         return a.EqualTo(b);
 //     }
@@ -500,10 +578,21 @@ public:
      */
     unsigned int bits() const;
 
+    /**
+     * (*this >> shift).GetLow64() and *this = uint64_t(b) << shift, touching
+     * only the words involved instead of shifting the whole number.
+     */
+    uint64_t GetLow64Shifted(unsigned int shift) const;
+    base_uint &SetLow64Shifted(uint64_t b, unsigned int shift);
+
     uint64_t GetLow64() const {
+#if BASE_UINT_LIMB_BITS == 64
+        return pn[0];
+#else
         static_assert(WIDTH >= 2, "Assertion WIDTH >= 2 failed (WIDTH = BITS / "
                                   "32). BITS is a template parameter.");
         return pn[0] | uint64_t(pn[1]) << 32;
+#endif
     }
 };
 
@@ -523,98 +612,255 @@ int base_uint<BITS>::CompareTo(const base_uint<BITS> &b) const {
 template <unsigned int BITS> unsigned int base_uint<BITS>::bits() const {
     for (int pos = WIDTH - 1; pos >= 0; pos--) {
         if (pn[pos]) {
-            for (int nbits = 31; nbits > 0; nbits--) {
-                if (pn[pos] & 1U << nbits) {
-                    return 32 * pos + nbits + 1;
-                }
-            }
-            return 32 * pos + 1;
+            return LIMB_BITS * (pos + 1) - CountLeadingZeros(pn[pos]);
         }
     }
     return 0;
 }
 
 template <unsigned int BITS>
-base_uint<BITS> &base_uint<BITS>::operator<<=(unsigned int shift) {
-    base_uint<BITS> a(*this);
+uint64_t base_uint<BITS>::GetLow64Shifted(unsigned int shift) const {
+    const unsigned int first = shift / LIMB_BITS;
+    const unsigned int s = shift % LIMB_BITS;
+    if (first >= unsigned(WIDTH)) {
+        return 0;
+    }
+    uint64_t res = pn[first] >> s;
+    // Word first + t lands at bit t * LIMB_BITS - s of the result.
+    for (unsigned int t = 1; first + t < unsigned(WIDTH) && t * LIMB_BITS - s < 64; t++) {
+        res |= uint64_t(pn[first + t]) << (t * LIMB_BITS - s);
+    }
+    return res;
+}
+
+template <unsigned int BITS>
+base_uint<BITS> &base_uint<BITS>::SetLow64Shifted(uint64_t b, unsigned int shift) {
     for (int i = 0; i < WIDTH; i++) {
         pn[i] = 0;
     }
-    int k = shift / 32;
-    shift = shift % 32;
+    const unsigned int first = shift / LIMB_BITS;
+    const unsigned int s = shift % LIMB_BITS;
+    if (first >= unsigned(WIDTH)) {
+        return *this;
+    }
+    pn[first] = limb_t(b << s);
+    // Bit t * LIMB_BITS - s of b is the lowest bit of word first + t.
+    for (unsigned int t = 1; first + t < unsigned(WIDTH) && t * LIMB_BITS - s < 64; t++) {
+        pn[first + t] = limb_t(b >> (t * LIMB_BITS - s));
+    }
+    return *this;
+}
+
+// The shifts are branch-free: the source words are read from a zero-padded
+// copy, so word and bit distances only change which index is loaded, and
+// the funnel of two adjacent words uses a split shift, (w >> 1) >> (L-1-s),
+// which is well defined for s == 0 as well.
+template <unsigned int BITS>
+base_uint<BITS> &base_uint<BITS>::operator<<=(unsigned int shift) {
+    // ext = [0, zeros..., a], so that ext[WIDTH + 1 + j] == a.pn[j] and
+    // every index in [-WIDTH - 1, 0) is zero.
+    limb_t ext[2 * WIDTH + 1] = {};
     for (int i = 0; i < WIDTH; i++) {
-        if (i + k + 1 < WIDTH && shift != 0) {
-            pn[i + k + 1] |= (a.pn[i] >> (32 - shift));
-        }
-        if (i + k < WIDTH) {
-            pn[i + k] |= (a.pn[i] << shift);
-        }
+        ext[WIDTH + 1 + i] = pn[i];
+    }
+    const unsigned int words = shift / LIMB_BITS;
+    const int k = words < unsigned(WIDTH) ? int(words) : WIDTH;
+    const unsigned int s = shift % LIMB_BITS;
+    for (int i = 0; i < WIDTH; i++) {
+        const limb_t hi = ext[WIDTH + 1 + i - k];
+        const limb_t lo = ext[WIDTH + i - k];
+        pn[i] = (hi << s) | ((lo >> 1) >> (LIMB_BITS - 1 - s));
     }
     return *this;
 }
 
 template <unsigned int BITS>
 base_uint<BITS> &base_uint<BITS>::operator>>=(unsigned int shift) {
-    base_uint<BITS> a(*this);
+    // ext = [a, zeros...], every index in [WIDTH, 2 * WIDTH] is zero.
+    limb_t ext[2 * WIDTH + 1] = {};
     for (int i = 0; i < WIDTH; i++) {
-        pn[i] = 0;
+        ext[i] = pn[i];
     }
-    int k = shift / 32;
-    shift = shift % 32;
+    const unsigned int words = shift / LIMB_BITS;
+    const int k = words < unsigned(WIDTH) ? int(words) : WIDTH;
+    const unsigned int s = shift % LIMB_BITS;
     for (int i = 0; i < WIDTH; i++) {
-        if (i - k - 1 >= 0 && shift != 0) {
-            pn[i - k - 1] |= (a.pn[i] << (32 - shift));
-        }
-        if (i - k >= 0) {
-            pn[i - k] |= (a.pn[i] >> shift);
-        }
+        const limb_t lo = ext[i + k];
+        const limb_t hi = ext[i + k + 1];
+        pn[i] = (lo >> s) | ((hi << 1) << (LIMB_BITS - 1 - s));
     }
     return *this;
 }
 
 template <unsigned int BITS>
 base_uint<BITS> &base_uint<BITS>::operator*=(uint32_t b32) {
-    uint64_t carry = 0;
+    dlimb_t carry = 0;
+    for (int i = 0; i < WIDTH; i++) {
+        dlimb_t n = carry + (dlimb_t)b32 * pn[i];
+        pn[i] = limb_t(n);
+        carry = n >> LIMB_BITS;
+    }
+    return *this;
+}
+
+template <unsigned int BITS>
+base_uint<BITS> &base_uint<BITS>::operator*=(const base_uint &b) {
+    base_uint<BITS> a;
+    for (int j = 0; j < WIDTH; j++) {
+        dlimb_t carry = 0;
+        for (int i = 0; i + j < WIDTH; i++) {
+            dlimb_t n = carry + a.pn[i + j] + (dlimb_t)pn[j] * b.pn[i];
+            a.pn[i + j] = limb_t(n);
+            carry = n >> LIMB_BITS;
+        }
+    }
+    *this = a;
+    return *this;
+}
+
+template <unsigned int BITS>
+base_uint<BITS> &base_uint<BITS>::MulU64ShiftRight(uint64_t b64, unsigned int shift) {
+#if BASE_UINT_LIMB_BITS == 64
+    if (shift >= BITS) {
+        *this = 0;
+        return *this;
+    }
+    const int k = shift / LIMB_BITS;
+    shift = shift % LIMB_BITS;
+
+    // Word i of the product only depends on words 0..i of *this, so the
+    // result can be written in place from the lowest word upwards: word i of
+    // the result needs product words i + k and i + k + 1.
+    dlimb_t carry = 0;
+    limb_t low = 0;
     for (int i = 0; i < WIDTH; i++) {
-        uint64_t n = carry + (uint64_t)b32 * pn[i];
-        pn[i] = n & 0xffffffff;
-        carry = n >> 32;
+        dlimb_t n = carry + (dlimb_t)b64 * pn[i];
+        carry = n >> LIMB_BITS;
+        const limb_t word = limb_t(n);
+        if (i == k) {
+            low = word;
+        } else if (i > k) {
+            pn[i - k - 1] = shift == 0 ? low : (low >> shift) | (word << (LIMB_BITS - shift));
+            low = word;
+        }
+    }
+    pn[WIDTH - k - 1] = low >> shift;
+    for (int i = WIDTH - k; i < WIDTH; i++) {
+        pn[i] = 0;
     }
     return *this;
+#else
+    if (b64 >> 32 == 0) {
+        *this *= uint32_t(b64);
+        return *this >>= shift;
+    }
+    base_uint high = *this;
+    *this *= uint32_t(b64);
+    high *= uint32_t(b64 >> 32);
+    *this += high <<= 32;
+    return *this >>= shift;
+#endif
 }
 
+// Knuth's algorithm D (TAOCP vol. 2, 4.3.1) on whole limbs: one quotient
+// limb per step, estimated from the top two limbs of the remainder and the
+// top limb of the normalized divisor.
 template <unsigned int BITS>
 base_uint<BITS> &base_uint<BITS>::operator/=(const base_uint &b) {
-    // make a copy, so we can shift.
-    base_uint<BITS> div = b;
-    // make a copy, so we can subtract.
-    base_uint<BITS> num = *this;
-    // the quotient.
-    *this = 0;
-    int num_bits = num.bits();
-    int div_bits = div.bits();
-    if (div_bits == 0) {
+    int n = WIDTH;
+    while (n > 0 && b.pn[n - 1] == 0) {
+        n--;
+    }
+    if (n == 0) {
         // throw uint_error("Division by zero");
         throw std::runtime_error("Division by zero");
     }
+    int m = WIDTH;
+    while (m > 0 && pn[m - 1] == 0) {
+        m--;
+    }
     // the result is certainly 0.
-    if (div_bits > num_bits) {
+    if (m < n) {
+        *this = 0;
         return *this;
     }
-    int shift = num_bits - div_bits;
-    // shift so that div and num align.
-    div <<= shift;
-    while (shift >= 0) {
-        if (num >= div) {
-            num -= div;
-            // set a bit of the result.
-            pn[shift / 32] |= (1 << (shift & 31));
+
+    // Single limb divisor: schoolbook short division, in place.
+    if (n == 1) {
+        const limb_t d = b.pn[0];
+        limb_t rem = 0;
+        for (int i = m - 1; i >= 0; i--) {
+            pn[i] = DivideLimbs(rem, pn[i], d, rem);
         }
-        // shift back.
-        div >>= 1;
-        shift--;
+        return *this;
+    }
+
+    // Normalize so that the top limb of the divisor has its high bit set,
+    // which keeps each estimated quotient limb at most 2 too large.
+    const int s = CountLeadingZeros(b.pn[n - 1]);
+    limb_t vn[WIDTH];
+    limb_t un[WIDTH + 1];
+    for (int i = n - 1; i > 0; i--) {
+        vn[i] = s == 0 ? b.pn[i] : (b.pn[i] << s) | (b.pn[i - 1] >> (LIMB_BITS - s));
+    }
+    vn[0] = b.pn[0] << s;
+    un[m] = s == 0 ? 0 : pn[m - 1] >> (LIMB_BITS - s);
+    for (int i = m - 1; i > 0; i--) {
+        un[i] = s == 0 ? pn[i] : (pn[i] << s) | (pn[i - 1] >> (LIMB_BITS - s));
     }
-    // num now contains the remainder of the division.
+    un[0] = pn[0] << s;
+
+    const limb_t vTop = vn[n - 1];
+    const limb_t vNext = vn[n - 2];
+    *this = 0;
+    for (int j = m - n; j >= 0; j--) {
+        // Estimate the quotient limb from the top two remainder limbs. The
+        // remainder's top limb never exceeds vTop; when it equals it, the
+        // estimate is capped at the largest limb.
+        limb_t qhat;
+        limb_t rhat;
+        bool fRhatOverflow = false;
+        if (un[j + n] < vTop) {
+            qhat = DivideLimbs(un[j + n], un[j + n - 1], vTop, rhat);
+        } else {
+            qhat = ~limb_t(0);
+            rhat = un[j + n - 1] + vTop;
+            fRhatOverflow = rhat < vTop;
+        }
+        // Refine with the next limb; this leaves qhat at most 1 too large.
+        while ( ! fRhatOverflow && dlimb_t(qhat) * vNext > ((dlimb_t(rhat) << LIMB_BITS) | un[j + n - 2])) {
+            qhat--;
+            rhat += vTop;
+            fRhatOverflow = rhat < vTop;
+        }
+
+        // Multiply and subtract qhat * vn from un[j .. j + n].
+        limb_t carry = 0;
+        limb_t borrow = 0;
+        for (int i = 0; i < n; i++) {
+            const dlimb_t p = dlimb_t(qhat) * vn[i] + carry;
+            carry = limb_t(p >> LIMB_BITS);
+            const dlimb_t t = dlimb_t(un[i + j]) - limb_t(p) - borrow;
+            un[i + j] = limb_t(t);
+            borrow = limb_t(t >> LIMB_BITS) != 0;
+        }
+        const dlimb_t t = dlimb_t(un[j + n]) - carry - borrow;
+        un[j + n] = limb_t(t);
+
+        // Went negative: qhat was 1 too large, add the divisor back.
+        if (limb_t(t >> LIMB_BITS) != 0) {
+            qhat--;
+            carry = 0;
+            for (int i = 0; i < n; i++) {
+                const dlimb_t sum = dlimb_t(un[i + j]) + vn[i] + carry;
+                un[i + j] = limb_t(sum);
+                carry = limb_t(sum >> LIMB_BITS);
+            }
+            un[j + n] += carry;
+        }
+        pn[j] = qhat;
+    }
+    // un now contains the remainder of the division, shifted left by s.
     return *this;
 }
 
@@ -664,6 +910,13 @@ public:
     friend arith_uint256 UintToArith256(const uint256 &);
 };
 
+uint256 ArithToUint256(const arith_uint256 &);
+arith_uint256 UintToArith256(const uint256 &);
+
+/** GetCompact() of count targets. */
+void GetCompactBatch(const arith_uint256 *targets, size_t count,
+                     uint32_t *nBitsOut) noexcept;
+
 
 // ---------------------------------------------------------------------------------------------------
 // Params
@@ -910,6 +1163,78 @@ public:
     int64_t GetBlockTime() const { return (int64_t)nTime; }
 };
 
+inline uint32_t ReadLE32(const uint8_t *ptr) {
+    uint32_t x;
+    memcpy((char *)&x, ptr, 4);
+    return le32toh(x);
+}
+
+inline uint64_t ReadLE64(const uint8_t *ptr) {
+    uint64_t x;
+    memcpy((char *)&x, ptr, 8);
+    return le64toh(x);
+}
+
+inline void WriteLE32(uint8_t *ptr, uint32_t x) {
+    uint32_t v = htole32(x);
+    memcpy(ptr, (char *)&v, 4);
+}
+
+inline void WriteLE64(uint8_t *ptr, uint64_t x) {
+    uint64_t v = htole64(x);
+    memcpy(ptr, (char *)&v, 8);
+}
+
+/**
+ * Non-owning view of a block header serialized as CBlockHeader's
+ * SerializationOp writes it: 80 bytes, little endian integers. Fields are
+ * decoded on access, straight from the buffer, which must outlive the view.
+ */
+class CBlockHeaderView {
+public:
+    static constexpr size_t SIZE = 80;
+
+    explicit CBlockHeaderView(const uint8_t *ptr) : ptr(ptr) {}
+
+    int32_t GetVersion() const { return int32_t(ReadLE32(ptr)); }
+    const uint8_t *GetPrevBlockHashData() const { return ptr + 4; }
+    const uint8_t *GetMerkleRootData() const { return ptr + 36; }
+    uint32_t GetTime() const { return ReadLE32(ptr + 68); }
+    int64_t GetBlockTime() const { return int64_t(GetTime()); }
+    uint32_t GetBits() const { return ReadLE32(ptr + 72); }
+    uint32_t GetNonce() const { return ReadLE32(ptr + 76); }
+
+    BlockHash GetPrevBlockHash() const {
+        BlockHash hash;
+        memcpy(hash.begin(), GetPrevBlockHashData(), 32);
+        return hash;
+    }
+
+    uint256 GetMerkleRoot() const {
+        uint256 hash{uint256::Uninitialized};
+        memcpy(hash.begin(), GetMerkleRootData(), 32);
+        return hash;
+    }
+
+    /** Owning copy. */
+    CBlockHeader ToHeader() const {
+        CBlockHeader header;
+        header.nVersion = GetVersion();
+        header.hashPrevBlock = GetPrevBlockHash();
+        header.hashMerkleRoot = GetMerkleRoot();
+        header.nTime = GetTime();
+        header.nBits = GetBits();
+        header.nNonce = GetNonce();
+        return header;
+    }
+
+    /** The serialized header. */
+    const uint8_t *data() const { return ptr; }
+
+private:
+    const uint8_t *ptr;
+};
+
 class CBlockIndex {
 public:
     //! pointer to the hash of the block, if any. Memory is owned by this
@@ -1085,11 +1410,11 @@ public:
     //     return true;
     // }
 
-    // //! Build the skiplist pointer for this entry.
-    // void BuildSkip();
+    //! Build the skiplist pointer for this entry.
+    void BuildSkip();
 
-    // //! Efficiently find an ancestor of this block.
-    // CBlockIndex *GetAncestor(int height);
+    //! Efficiently find an ancestor of this block.
+    CBlockIndex *GetAncestor(int height);
     const CBlockIndex *GetAncestor(int height) const;
 };
 
@@ -1131,7 +1456,11 @@ const CBlockIndex *CBlockIndex::GetAncestor(int height) const {
             pindexWalk = pindexWalk->pskip;
             heightWalk = heightSkip;
         } else {
-            assert(pindexWalk->pprev);
+            // Simulated chains may start above the genesis block: no ancestor
+            // at that height.
+            if (pindexWalk->pprev == nullptr) {
+                return nullptr;
+            }
             pindexWalk = pindexWalk->pprev;
             heightWalk--;
         }
@@ -1139,12 +1468,256 @@ const CBlockIndex *CBlockIndex::GetAncestor(int height) const {
     return pindexWalk;
 }
 
+inline
+CBlockIndex *CBlockIndex::GetAncestor(int height) {
+    return const_cast<CBlockIndex *>(
+        const_cast<const CBlockIndex *>(this)->GetAncestor(height));
+}
+
+// Blocks must be linked in order, each after its pprev got its own pskip.
+inline
+void CBlockIndex::BuildSkip() {
+    if (pprev) {
+        pskip = pprev->GetAncestor(GetSkipHeight(nHeight));
+    }
+}
+
+// https://gitlab.com/bitcoin-cash-node/bitcoin-cash-node/-/blob/master/src/chain.cpp
+/**
+ * Expected number of hashes to find a block with the given compact target:
+ * 2**256 / (target+1), or 0 for an invalid target.
+ */
+arith_uint256 GetBlockProof(uint32_t nBits);
+
+inline
+arith_uint256 GetBlockProof(const CBlockIndex &block) {
+    return GetBlockProof(block.nBits);
+}
+
+/**
+ * GetBlockProof of count compact targets, to proofsOut. Runs of equal nBits,
+ * the norm before the 2017 DAA, are divided once.
+ */
+void GetBlockProofs(const uint32_t *nBits, size_t count, arith_uint256 *proofsOut);
+
+/**
+ * Chain work of count consecutive blocks on top of nBaseWork, the work of the
+ * chain below the first one: chainWorkOut[i] is nBaseWork plus the proofs of
+ * nBits[0..i]. A parallel prefix sum on nThreads worker threads (0: one per
+ * hardware thread), exact whatever nThreads is.
+ */
+void ComputeChainWork(const uint32_t *nBits,
+                      size_t count,
+                      const arith_uint256 &nBaseWork,
+                      arith_uint256 *chainWorkOut,
+                      unsigned int nThreads);
+
+/**
+ * Block history as parallel arrays indexed by height, for the consumers that
+ * only read timestamps and targets (ASERT, simulations): 8 bytes per block
+ * instead of a whole CBlockIndex, 40 with the optional chain work.
+ * Holds the heights [FirstHeight(), TipHeight()].
+ */
+class CChainStore {
+public:
+    explicit CChainStore(int nFirstHeight = 0, bool fChainWork = false)
+        : nFirstHeight(nFirstHeight)
+        , fChainWork(fChainWork)
+    {}
+
+    void reserve(size_t n) {
+        vTime.reserve(n);
+        vBits.reserve(n);
+        if (fChainWork) {
+            vChainWork.reserve(n);
+        }
+    }
+
+    /** Appends the block at height TipHeight() + 1. */
+    void push_back(uint32_t nTime, uint32_t nBits) {
+        if (fChainWork) {
+            vChainWork.push_back(vChainWork.empty() ? GetBlockProof(nBits)
+                                                    : vChainWork.back() + GetBlockProof(nBits));
+        }
+        vTime.push_back(nTime);
+        vBits.push_back(nBits);
+    }
+
+    /**
+     * Appends count blocks at once, their chain work, if kept, computed by
+     * ComputeChainWork() on nThreads threads.
+     */
+    void append(const uint32_t *nTimes, const uint32_t *nBits, size_t count, unsigned int nThreads = 1) {
+        vTime.insert(vTime.end(), nTimes, nTimes + count);
+        vBits.insert(vBits.end(), nBits, nBits + count);
+        if (fChainWork) {
+            const arith_uint256 nBaseWork = vChainWork.empty() ? arith_uint256() : vChainWork.back();
+            vChainWork.resize(vChainWork.size() + count);
+            ComputeChainWork(nBits, count, nBaseWork, vChainWork.data() + vChainWork.size() - count, nThreads);
+        }
+    }
+
+    /**
+     * Starts keeping chain work, computing it for the blocks already in the
+     * store on nThreads threads. Does nothing if it is already kept.
+     */
+    void EnableChainWork(unsigned int nThreads = 1) {
+        if ( ! fChainWork) {
+            fChainWork = true;
+            vChainWork.resize(vBits.size());
+            ComputeChainWork(vBits.data(), vBits.size(), arith_uint256(), vChainWork.data(), nThreads);
+        }
+    }
+
+    /** Drops the blocks above nHeight, FirstHeight() - 1 emptying the store. */
+    void truncate(int nHeight) {
+        assert(int64_t(nHeight) >= int64_t(nFirstHeight) - 1);
+        const size_t n = size_t(int64_t(nHeight) + 1 - nFirstHeight);
+        if (n < vTime.size()) {
+            vTime.resize(n);
+            vBits.resize(n);
+            if (fChainWork) {
+                vChainWork.resize(n);
+            }
+        }
+    }
+
+    size_t size() const { return vTime.size(); }
+    bool empty() const { return vTime.empty(); }
+    int FirstHeight() const { return nFirstHeight; }
+    int TipHeight() const { return nFirstHeight + int(vTime.size()) - 1; }
+    bool Contains(int nHeight) const { return nHeight >= nFirstHeight && nHeight <= TipHeight(); }
+    bool HasChainWork() const { return fChainWork; }
+
+    uint32_t GetTime(int nHeight) const { return vTime[nHeight - nFirstHeight]; }
+    int64_t GetBlockTime(int nHeight) const { return int64_t(GetTime(nHeight)); }
+    uint32_t GetBits(int nHeight) const { return vBits[nHeight - nFirstHeight]; }
+    const arith_uint256 &GetChainWork(int nHeight) const {
+        assert(fChainWork);
+        return vChainWork[nHeight - nFirstHeight];
+    }
+
+    /** Contiguous arrays, element 0 being FirstHeight(). */
+    const uint32_t *Times() const { return vTime.data(); }
+    const uint32_t *Bits() const { return vBits.data(); }
+
+private:
+    int nFirstHeight;
+    bool fChainWork;
+    std::vector<uint32_t> vTime;
+    std::vector<uint32_t> vBits;
+    std::vector<arith_uint256> vChainWork;
+};
+
 
 // ---------------------------------------------------------------------------------------------------
 // ---------------------------------------------------------------------------------------------------
 // ---------------------------------------------------------------------------------------------------
 // ---------------------------------------------------------------------------------------------------
 
+/**
+ * ASERT with 2^x approximated on [0, 1) by a polynomial of degree nOrder,
+ * in fixed point with nRBits bits after the radix: mining.py's aserti1,
+ * aserti2 and aserti3 for nRBits = 16. Orders 1 and 2 use the mining.py
+ * polynomials, order 3 the BCHN cubic. Like BCHN, and unlike mining.py,
+ * the exponent division truncates and the result is clamped to powLimit.
+ *
+ * Defined in aserti3-416.cpp and explicitly instantiated for nRBits = 16
+ * and every order, see ASERTI_INSTANTIATE there.
+ */
+template <int nOrder, int nRBits>
+void CalculateASERTiShiftsAndFactor(const int64_t nPowTargetSpacing,
+                                    const int64_t nTimeDiff,
+                                    const int64_t nHeightDiff,
+                                    const int64_t nHalfLife,
+                                    int64_t &shifts,
+                                    uint64_t &factor) noexcept;
+
+/**
+ * Bits after the radix of the factor of order nOrder: the quadratic keeps
+ * twice as many, as mining.py does.
+ */
+template <int nOrder, int nRBits>
+constexpr int ASERTiFactorBits = nOrder == 2 ? 2 * nRBits : nRBits;
+
+template <int nFactorBits>
+arith_uint256 ApplyASERTiShiftsAndFactor(const arith_uint256 &refTarget,
+                                         const int64_t shifts,
+                                         const uint64_t factor,
+                                         const arith_uint256 &powLimit) noexcept;
+
+/**
+ * Next target of the aserti<nOrder> family. Not bit-identical to mining.py's
+ * next_bits_aserti: when the exponent is negative (blocks ahead of schedule)
+ * the division truncates towards zero where Python floors, so the target can
+ * differ by one step of the fixed-point exponent. Non-negative exponents give
+ * the same nBits.
+ */
+template <int nOrder, int nRBits>
+arith_uint256 CalculateASERTi(const arith_uint256 refTarget,
+                              const int64_t nPowTargetSpacing,
+                              const int64_t nTimeDiff,
+                              const int64_t nHeightDiff,
+                              const arith_uint256 powLimit,
+                              const int64_t nHalfLife) noexcept;
+
+/**
+ * CalculateASERT split in two halves: the exponent, whole shifts and
+ * fixed-point factor only depend on the time/height differences, the final
+ * step applies them to the reference target.
+ * These and CalculateASERT are CalculateASERTi<3, 16>.
+ */
+void CalculateASERTShiftsAndFactor(const int64_t nPowTargetSpacing,
+                                   const int64_t nTimeDiff,
+                                   const int64_t nHeightDiff,
+                                   const int64_t nHalfLife,
+                                   int64_t &shifts,
+                                   uint64_t &factor) noexcept;
+
+arith_uint256 ApplyASERTShiftsAndFactor(const arith_uint256 &refTarget,
+                                        const int64_t shifts,
+                                        const uint64_t factor,
+                                        const arith_uint256 &powLimit) noexcept;
+
+/**
+ * CalculateASERTShiftsAndFactor for count evaluations sharing the same
+ * nPowTargetSpacing and nHalfLife. Uses AVX-512 or AVX2 when the CPU supports
+ * them (see ASERTKernelName()), bit-identical to the scalar version.
+ */
+void CalculateASERTShiftsAndFactors(const int64_t nPowTargetSpacing,
+                                    const int64_t nHalfLife,
+                                    const int64_t *nTimeDiffs,
+                                    const int64_t *nHeightDiffs,
+                                    size_t count,
+                                    int64_t *shiftsOut,
+                                    uint64_t *factorsOut) noexcept;
+
+/** Name of the kernel selected at load time: "avx512", "avx2" or "scalar". */
+const char *ASERTKernelName() noexcept;
+
+/**
+ * CalculateASERTShiftsAndFactors on the named kernel instead of the selected
+ * one, for tests comparing them. Returns false, computing nothing, if this
+ * build has no such kernel or the CPU cannot run it.
+ */
+bool CalculateASERTShiftsAndFactorsOn(const char *kernelName,
+                                      const int64_t nPowTargetSpacing,
+                                      const int64_t nHalfLife,
+                                      const int64_t *nTimeDiffs,
+                                      const int64_t *nHeightDiffs,
+                                      size_t count,
+                                      int64_t *shiftsOut,
+                                      uint64_t *factorsOut);
+
+// https://gitlab.com/freetrader/bitcoin-cash-node/-/blob/affe4657dc85f25b6782648960579bb2a8fedd6a/src/pow.cpp#L106
+arith_uint256 CalculateASERT(const arith_uint256 refTarget,
+                             const int64_t nPowTargetSpacing,
+                             const int64_t nTimeDiff,
+                             const int64_t nHeightDiff,
+                             const arith_uint256 powLimit,
+                             const int64_t nHalfLife,
+                             bool debugASERT) noexcept;
+
 // https://gitlab.com/freetrader/bitcoin-cash-node/-/blob/affe4657dc85f25b6782648960579bb2a8fedd6a/src/pow.cpp#L52
 uint32_t GetNextASERTWorkRequired(const CBlockIndex *pindexPrev,
                                   const CBlockHeader *pblock,
@@ -1152,6 +1725,143 @@ uint32_t GetNextASERTWorkRequired(const CBlockIndex *pindexPrev,
                                   const CBlockIndex *pindexReferenceBlock,
                                   bool debugASERT) noexcept;
 
+/**
+ * Everything GetNextASERTWorkRequired derives from the reference block and
+ * the consensus parameters, computed once: validating or simulating a long
+ * run of blocks against the same reference block then does no redundant
+ * compact decoding nor parameter lookups.
+ *
+ * The testnet minimum difficulty rule needs the new block's timestamp and is
+ * not applied here.
+ */
+class ASERTContext {
+public:
+    ASERTContext(const CBlockIndex &referenceBlock,
+                 const Consensus::Params &params);
+    ASERTContext(int nRefHeight, int64_t nRefTime, uint32_t nRefBits,
+                 const Consensus::Params &params);
+
+    /**
+     * Compact target of the block following a block at height nTipHeight
+     * with timestamp nTipTime.
+     */
+    uint32_t next(int64_t nTipTime, int nTipHeight) const noexcept;
+
+    /** next() with CalculateASERTi<nOrder, nRBits>. */
+    template <int nOrder, int nRBits>
+    uint32_t next(int64_t nTipTime, int nTipHeight) const noexcept;
+
+    int nRefHeight;
+    int64_t nRefTime;
+    uint32_t nRefBits;
+    arith_uint256 refTarget;
+    arith_uint256 powLimit;
+    int64_t nPowTargetSpacing;
+    int64_t nHalfLife;
+};
+
+/**
+ * Batch version of CalculateASERT for a fixed reference block.
+ * For every i in [0, count), writes to nBitsOut[i] the compact target that
+ * follows a block nTimeDiffs[i] seconds and nHeightDiffs[i] blocks after the
+ * reference block, whose compact target is nRefBits.
+ * The reference target and powLimit are decoded only once for the whole batch.
+ */
+void CalculateASERTBatch(uint32_t nRefBits,
+                         const int64_t *nTimeDiffs,
+                         const int64_t *nHeightDiffs,
+                         size_t count,
+                         const Consensus::Params &params,
+                         uint32_t *nBitsOut) noexcept;
+
+/**
+ * GetNextASERTWorkRequired for the block after nPrevHeight of a CChainStore,
+ * with nRefHeight as the reference block. Both must be in the store.
+ * As with ASERTContext, the testnet minimum difficulty rule is not applied.
+ */
+uint32_t GetNextASERTWorkRequired(const CChainStore &chain,
+                                  int nPrevHeight,
+                                  int nRefHeight,
+                                  const Consensus::Params &params) noexcept;
+
+/**
+ * nBitsOut[i] = GetNextASERTWorkRequired(chain, nFirstPrevHeight + i,
+ * nRefHeight, params) for i in [0, count), through CalculateASERTBatch:
+ * validating a stored chain reads the time array sequentially and runs the
+ * vectorized kernel.
+ */
+void GetNextASERTWorkRequiredRange(const CChainStore &chain,
+                                   int nRefHeight,
+                                   int nFirstPrevHeight,
+                                   size_t count,
+                                   const Consensus::Params &params,
+                                   uint32_t *nBitsOut) noexcept;
+
+/** An ASERT entry of mining.py's Algos. */
+struct ASERTiVariant {
+    // Degree of the 2^x approximation: 1, 2 or 3 (radix bits are always 16).
+    int nOrder;
+    // mining.py's tau, in seconds; 0 for Consensus::Params::nDAAHalfLife.
+    int64_t nHalfLife;
+    bool fMedianOfThree;
+};
+
+/**
+ * Looks up an ASERT variant by its mining.py Algos name (aserti1-144 to
+ * aserti3-mo3-576, aserti3-416-cpp and aserti3-mo3-416-cpp). Returns false
+ * if unknown.
+ * The native variants follow BCHN's integer arithmetic, not mining.py's:
+ * ahead of schedule they can differ from the Python Algos of the same name
+ * (see CalculateASERTi), so compare them as variants, not as exact ports.
+ */
+bool GetASERTiVariant(const std::string &name, ASERTiVariant &variant);
+
+/** Names GetASERTiVariant() knows, in mining.py's Algos order. */
+std::vector<std::string> GetASERTiVariantNames();
+
+// https://gitlab.com/bitcoin-cash-node/bitcoin-cash-node/-/blob/v0.21.0/src/pow.cpp#L99
+/**
+ * Median by timestamp of pindex and its two predecessors, ties resolved
+ * as mining.py's suitable_block_index. pindex->pprev->pprev must exist.
+ */
+const CBlockIndex *GetSuitableBlock(const CBlockIndex *pindex) noexcept;
+
+/** GetSuitableBlock for the block at nHeight of a CChainStore. */
+int GetSuitableBlockHeight(const CChainStore &chain, int nHeight) noexcept;
+
+/**
+ * Median-of-three ASERT (the aserti3-mo3-* algorithms): ASERT between the
+ * suitable blocks of pindexAnchor and pindexPrev instead of between the
+ * blocks themselves, so a single out-of-order timestamp cannot move the
+ * target. Right after the anchor the suitable tip may still be at or below
+ * the suitable anchor, the target is then the suitable anchor's.
+ */
+uint32_t GetNextASERTMo3WorkRequired(const CBlockIndex *pindexPrev,
+                                     const CBlockHeader *pblock,
+                                     const Consensus::Params &params,
+                                     const CBlockIndex *pindexAnchor,
+                                     bool debugASERT) noexcept;
+
+/**
+ * GetNextASERTMo3WorkRequired for the block after nPrevHeight of a
+ * CChainStore. The store must hold the two blocks below nAnchorHeight.
+ */
+uint32_t GetNextASERTMo3WorkRequired(const CChainStore &chain,
+                                     int nPrevHeight,
+                                     int nAnchorHeight,
+                                     const Consensus::Params &params) noexcept;
+
+/**
+ * Next target of variant for the block after nPrevHeight of a CChainStore,
+ * nAnchorHeight being the reference block, or its anchor for the median of
+ * three variants.
+ */
+uint32_t GetNextASERTiWorkRequired(const ASERTiVariant &variant,
+                                   const CChainStore &chain,
+                                   int nPrevHeight,
+                                   int nAnchorHeight,
+                                   const Consensus::Params &params) noexcept;
+
 
 // // https://gitlab.com/jtoomim/bitcoin-cash-node/-/blob/fd92035c2e8d16360fb3e314b626bf52f2a2be67/src/pow.cpp#L299
 // /**
@@ -0,0 +1,726 @@
+// g++ -O2 -std=c++17 -pthread aserti3-416_bench.cpp aserti3-416.cpp aserti3-416_simd.cpp aserti3-416_random.cpp aserti3-416_validation.cpp aserti3-416_pow.cpp aserti3-416_chainwork.cpp -o aserti3-416_bench
+
+/**
+ * Copyright (c) 2020 Fernando Pelliccioni
+ */
+
+// Microbenchmarks for the arithmetic used in the ASERT hot path.
+// Reports nanoseconds and TSC cycles per call.
+//
+// Options, named as Google Benchmark's so the same tooling can track them:
+//   --benchmark_filter=<regex>        only run the benchmarks matching regex
+//   --benchmark_format=<console|json> what to write to stdout
+//   --benchmark_out=<file>            also write the results as JSON to file
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <iterator>
+#include <random>
+#include <regex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "aserti3-416.hpp"
+#include "aserti3-416_pow.hpp"
+#include "aserti3-416_random.hpp"
+#include "aserti3-416_validation.hpp"
+
+namespace {
+
+inline uint64_t ReadCycles() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+template <typename T>
+inline void DoNotOptimize(T const& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Per call.
+struct Result {
+    double ns;
+    double cpuNs;
+    double cycles;
+    size_t iterations;
+
+    // The same run seen as count calls per iteration.
+    Result PerCall(size_t count) const {
+        return {ns / count, cpuNs / count, cycles / count, iterations * count};
+    }
+};
+
+struct Record {
+    std::string name;
+    Result result;
+};
+
+std::vector<Record> records;
+std::regex filter(".*");
+bool fConsole = true;
+
+bool Selected(char const* name) {
+    return std::regex_search(name, filter);
+}
+
+// Whether any of labels passes the filter, so that benchmarks with large
+// fixtures only build them when one of their cases runs.
+bool AnySelected(std::vector<std::string> const& labels) {
+    return std::any_of(labels.begin(), labels.end(), [](std::string const& label) {
+        return Selected(label.c_str());
+    });
+}
+
+template <typename F>
+Result Measure(size_t iterations, F f) {
+    // warm up
+    for (size_t i = 0; i < iterations / 10; ++i) {
+        f(i);
+    }
+
+    std::clock_t const startCpu = std::clock();
+    auto const start = std::chrono::steady_clock::now();
+    uint64_t const startCycles = ReadCycles();
+    for (size_t i = 0; i < iterations; ++i) {
+        f(i);
+    }
+    uint64_t const cycles = ReadCycles() - startCycles;
+    auto const elapsed = std::chrono::steady_clock::now() - start;
+    std::clock_t const cpu = std::clock() - startCpu;
+
+    return {std::chrono::duration<double, std::nano>(elapsed).count() / iterations,
+            1e9 * double(cpu) / CLOCKS_PER_SEC / iterations,
+            double(cycles) / iterations,
+            iterations};
+}
+
+void Print(char const* name, Result r) {
+    records.push_back({name, r});
+    if (fConsole) {
+        std::printf("%-48s %10.2f ns/call %10.2f cycles/call\n", name, r.ns, r.cycles);
+    }
+}
+
+template <typename F>
+void Bench(char const* name, size_t iterations, F f) {
+    if (Selected(name)) {
+        Print(name, Measure(iterations, f));
+    }
+}
+
+// Runs f(i, distance) for every distance in [0, 255] and prints the fastest,
+// average and slowest distance.
+template <typename F>
+void BenchDistances(char const* name, size_t iterations, F f) {
+    if ( ! Selected(name)) {
+        return;
+    }
+    Result min {1e300, 1e300, 1e300, iterations};
+    Result max {0, 0, 0, iterations};
+    Result sum {0, 0, 0, 256 * iterations};
+    for (unsigned int distance = 0; distance < 256; ++distance) {
+        Result const r = Measure(iterations, [&](size_t i) { f(i, distance); });
+        min = r.ns < min.ns ? r : min;
+        max = r.ns > max.ns ? r : max;
+        sum.ns += r.ns;
+        sum.cpuNs += r.cpuNs;
+        sum.cycles += r.cycles;
+    }
+    char label[96];
+    std::snprintf(label, sizeof(label), "%s, fastest distance", name);
+    Print(label, min);
+    std::snprintf(label, sizeof(label), "%s, average over 0..255", name);
+    Print(label, {sum.ns / 256, sum.cpuNs / 256, sum.cycles / 256, sum.iterations});
+    std::snprintf(label, sizeof(label), "%s, slowest distance", name);
+    Print(label, max);
+}
+
+// Targets in the range CalculateASERT works with: up to powLimit.
+std::vector<arith_uint256> RandomTargets(size_t n, std::mt19937_64& rng) {
+    std::vector<arith_uint256> res;
+    res.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t const nBits = ((0x04 + rng() % 0x19) << 24) | (0x008000 + rng() % 0x7f8000);
+        res.push_back(arith_uint256().SetCompact(nBits));
+    }
+    return res;
+}
+
+// The base_uint operators themselves, on targets and on full width values.
+void BenchArith(std::mt19937_64& rng) {
+    constexpr size_t n = 1024;
+    constexpr size_t mask = n - 1;
+    auto const targets = RandomTargets(n, rng);
+    std::vector<arith_uint256> wide(n);
+    std::vector<arith_uint256> divisors64(n);
+    std::vector<uint32_t> factors(n);
+    for (size_t i = 0; i < n; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            wide[i] <<= 64;
+            wide[i] += arith_uint256(rng());
+        }
+        divisors64[i] = arith_uint256(rng() | 1);
+        factors[i] = uint32_t(rng());
+    }
+
+    Bench("x + y", 10000000, [&](size_t i) {
+        DoNotOptimize(wide[i & mask] + wide[(i + 1) & mask]);
+    });
+    Bench("x - y", 10000000, [&](size_t i) {
+        arith_uint256 r = wide[i & mask];
+        r -= wide[(i + 1) & mask];
+        DoNotOptimize(r);
+    });
+    Bench("x * uint32", 10000000, [&](size_t i) {
+        DoNotOptimize(targets[i & mask] * factors[i & mask]);
+    });
+    Bench("x / y, 256-bit x, 64-bit y", 1000000, [&](size_t i) {
+        DoNotOptimize(wide[i & mask] / divisors64[i & mask]);
+    });
+    Bench("x / y, 256-bit x, target y", 1000000, [&](size_t i) {
+        DoNotOptimize(wide[i & mask] / targets[i & mask]);
+    });
+    Bench("x / y, target x, target y", 1000000, [&](size_t i) {
+        DoNotOptimize(targets[i & mask] / targets[(i + 1) & mask]);
+    });
+}
+
+// The chain work of a block, 2^256 / (target + 1): a full width division by
+// a target, once per block.
+void BenchBlockProof(std::mt19937_64& rng) {
+    constexpr size_t n = 1024;
+    constexpr size_t mask = n - 1;
+    auto const targets = RandomTargets(n, rng);
+    std::vector<uint32_t> compacts(n);
+    GetCompactBatch(targets.data(), n, compacts.data());
+
+    Bench("GetBlockProof", 1000000, [&](size_t i) {
+        DoNotOptimize(GetBlockProof(compacts[i & mask]));
+    });
+}
+
+void BenchMulShift(std::mt19937_64& rng) {
+    constexpr size_t n = 1024;
+    constexpr size_t mask = n - 1;
+    auto const targets = RandomTargets(n, rng);
+    std::vector<uint64_t> factors(n);
+    for (auto& f : factors) {
+        f = rng() % 65536;
+    }
+
+    Bench("(x * arith_uint256(factor)) >> 16", 10000000, [&](size_t i) {
+        arith_uint256 r = (targets[i & mask] * arith_uint256(factors[i & mask])) >> 16;
+        DoNotOptimize(r);
+    });
+
+    Bench("x.MulU64ShiftRight(factor, 16)", 10000000, [&](size_t i) {
+        arith_uint256 r = targets[i & mask];
+        r.MulU64ShiftRight(factors[i & mask], 16);
+        DoNotOptimize(r);
+    });
+}
+
+// Latency of operator<<= and operator>>= for every distance in [0, 255],
+// plus a run with random distances, where a branchy implementation would
+// pay for mispredictions.
+void BenchShifts(std::mt19937_64& rng) {
+    constexpr size_t n = 1024;
+    constexpr size_t mask = n - 1;
+    auto const targets = RandomTargets(n, rng);
+    std::vector<unsigned int> distances(n);
+    for (auto& d : distances) {
+        d = rng() % 256;
+    }
+
+    Bench("x << random distance", 10000000, [&](size_t i) {
+        arith_uint256 r = targets[i & mask] << distances[i & mask];
+        DoNotOptimize(r);
+    });
+    Bench("x >> random distance", 10000000, [&](size_t i) {
+        arith_uint256 r = targets[i & mask] >> distances[i & mask];
+        DoNotOptimize(r);
+    });
+
+    BenchDistances("x << distance", 200000, [&](size_t i, unsigned int distance) {
+        arith_uint256 r = targets[i & mask] << distance;
+        DoNotOptimize(r);
+    });
+    BenchDistances("x >> distance", 200000, [&](size_t i, unsigned int distance) {
+        arith_uint256 r = targets[i & mask] >> distance;
+        DoNotOptimize(r);
+    });
+}
+
+void BenchCompact(std::mt19937_64& rng) {
+    constexpr size_t n = 1024;
+    constexpr size_t mask = n - 1;
+    auto const targets = RandomTargets(n, rng);
+    std::vector<uint32_t> compacts(n);
+    GetCompactBatch(targets.data(), n, compacts.data());
+
+    Bench("x.bits()", 10000000, [&](size_t i) {
+        DoNotOptimize(targets[i & mask].bits());
+    });
+    Bench("x.GetCompact()", 10000000, [&](size_t i) {
+        DoNotOptimize(targets[i & mask].GetCompact());
+    });
+    Bench("arith_uint256().SetCompact(nBits)", 10000000, [&](size_t i) {
+        arith_uint256 r;
+        r.SetCompact(compacts[i & mask]);
+        DoNotOptimize(r);
+    });
+    Bench("GetCompactBatch of 1024 targets", 10000, [&](size_t) {
+        GetCompactBatch(targets.data(), n, compacts.data());
+        DoNotOptimize(compacts[0]);
+    });
+}
+
+Consensus::Params MainnetParams() {
+    Consensus::Params params;
+    params.powLimit = uint256S("00000000ffffffffffffffffffffffffffffffffffffffffffffffffffffffff");
+    params.nPowTargetTimespan = 14 * 24 * 60 * 60;
+    params.nPowTargetSpacing = 10 * 60;
+    params.fPowAllowMinDifficultyBlocks = false;
+    params.nDAAHalfLife = 2 * 24 * 60 * 60;
+    return params;
+}
+
+// CalculateASERT with the tip a fixed time off schedule, 1 to 100000 blocks
+// after the reference block. Large deviations reach powLimit or the minimum
+// target, which take the clamped paths.
+void BenchCalculateASERT(std::mt19937_64& rng) {
+    constexpr size_t n = 1024;
+    constexpr size_t mask = n - 1;
+    auto const params = MainnetParams();
+    arith_uint256 const powLimit = UintToArith256(params.powLimit);
+    arith_uint256 const refTarget = arith_uint256().SetCompact(0x1804dafe);
+
+    std::vector<int64_t> heightDiffs(n);
+    std::vector<int64_t> jitters(n);
+    for (size_t i = 0; i < n; ++i) {
+        heightDiffs[i] = 1 + rng() % 100000;
+        jitters[i] = int64_t(rng() % 1201) - 600;
+    }
+
+    for (int64_t nDeviation : {-8640000, -864000, -86400, -3600, 0, 3600, 86400, 864000, 8640000}) {
+        char label[96];
+        std::snprintf(label, sizeof(label), "CalculateASERT, %+lld s off schedule", (long long)nDeviation);
+        Bench(label, 2000000, [&](size_t i) {
+            int64_t const nHeightDiff = heightDiffs[i & mask];
+            int64_t const nTimeDiff = nHeightDiff * params.nPowTargetSpacing + nDeviation + jitters[i & mask];
+            DoNotOptimize(CalculateASERT(refTarget, params.nPowTargetSpacing, nTimeDiff, nHeightDiff,
+                                         powLimit, params.nDAAHalfLife, false));
+        });
+    }
+}
+
+// Tip timestamps up to +-10 days off schedule, 1 to 100000 blocks after the
+// reference block.
+void BenchNextWorkRequired(std::mt19937_64& rng) {
+    constexpr size_t n = 1024;
+    constexpr size_t mask = n - 1;
+    auto const params = MainnetParams();
+
+    CBlockIndex reference;
+    reference.nHeight = 661647;
+    reference.nTime = 1605447844;
+    reference.nBits = 0x1804dafe;
+
+    std::vector<CBlockIndex> tips(n);
+    for (auto& tip : tips) {
+        int const nHeightDiff = 1 + rng() % 100000;
+        tip.nHeight = reference.nHeight + nHeightDiff;
+        tip.nTime = reference.nTime + nHeightDiff * 600 + int64_t(rng() % 1728001) - 864000;
+    }
+    CBlockHeader const blockDummy = CBlockHeader();
+
+    Bench("GetNextASERTWorkRequired", 2000000, [&](size_t i) {
+        DoNotOptimize(GetNextASERTWorkRequired(&tips[i & mask], &blockDummy, params, &reference, false));
+    });
+
+    ASERTContext const context(reference, params);
+    Bench("ASERTContext::next", 2000000, [&](size_t i) {
+        DoNotOptimize(context.next(tips[i & mask].nTime, tips[i & mask].nHeight));
+    });
+    Bench("ASERTContext::next<1, 16>", 2000000, [&](size_t i) {
+        DoNotOptimize(context.next<1, 16>(tips[i & mask].nTime, tips[i & mask].nHeight));
+    });
+    Bench("ASERTContext::next<2, 16>", 2000000, [&](size_t i) {
+        DoNotOptimize(context.next<2, 16>(tips[i & mask].nTime, tips[i & mask].nHeight));
+    });
+}
+
+// Next work required for every block of a one million block chain, from
+// linked CBlockIndex objects and from a CChainStore. Times are per block.
+void BenchChainStore(std::mt19937_64& rng) {
+    char const* const names[] = {
+        "GetNextASERTWorkRequired(CBlockIndex), 1M",
+        "GetNextASERTWorkRequired(CChainStore), 1M",
+        "GetNextASERTWorkRequiredRange, 1M",
+    };
+    if (std::none_of(std::begin(names), std::end(names), Selected)) {
+        return;
+    }
+
+    constexpr size_t n = 1000000;
+    auto const params = MainnetParams();
+    CBlockHeader const blockDummy = CBlockHeader();
+
+    std::vector<CBlockIndex> blocks(n);
+    CChainStore chain(0);
+    chain.reserve(n);
+    int64_t nTime = 1605447844;
+    for (size_t i = 0; i < n; ++i) {
+        nTime += 600 + int64_t(rng() % 1201) - 600;
+        blocks[i].nHeight = int(i);
+        blocks[i].nTime = uint32_t(nTime);
+        blocks[i].nBits = 0x1804dafe;
+        blocks[i].pprev = i > 0 ? &blocks[i - 1] : nullptr;
+        chain.push_back(uint32_t(nTime), 0x1804dafe);
+    }
+    std::vector<uint32_t> nBitsOut(n);
+
+    if (fConsole) {
+        std::printf("CBlockIndex: %zu bytes per block, CChainStore: %zu bytes per block\n",
+                    sizeof(CBlockIndex), 2 * sizeof(uint32_t));
+    }
+
+    if (Selected(names[0])) {
+        Result const r = Measure(5, [&](size_t) {
+            for (size_t i = 0; i < n; ++i) {
+                nBitsOut[i] = GetNextASERTWorkRequired(&blocks[i], &blockDummy, params, &blocks[0], false);
+            }
+            DoNotOptimize(nBitsOut[n - 1]);
+        });
+        Print(names[0], r.PerCall(n));
+    }
+
+    if (Selected(names[1])) {
+        Result const r = Measure(5, [&](size_t) {
+            for (size_t i = 0; i < n; ++i) {
+                nBitsOut[i] = GetNextASERTWorkRequired(chain, int(i), 0, params);
+            }
+            DoNotOptimize(nBitsOut[n - 1]);
+        });
+        Print(names[1], r.PerCall(n));
+    }
+
+    if (Selected(names[2])) {
+        Result const r = Measure(5, [&](size_t) {
+            GetNextASERTWorkRequiredRange(chain, 0, 0, n, params, nBitsOut.data());
+            DoNotOptimize(nBitsOut[n - 1]);
+        });
+        Print(names[2], r.PerCall(n));
+    }
+}
+
+// Validating the nBits of a one million header chain, on one thread and on
+// every hardware thread. Times are per header.
+void BenchValidation(std::mt19937_64& rng) {
+    unsigned int const nHardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<unsigned int> threadCounts = {1u};
+    if (nHardwareThreads > 1) {
+        threadCounts.push_back(nHardwareThreads);
+    }
+    std::vector<std::string> labels;
+    for (unsigned int nThreads : threadCounts) {
+        labels.push_back("FindFirstASERTBitsMismatch, 1M, " + std::to_string(nThreads) + " threads");
+    }
+    if ( ! AnySelected(labels)) {
+        return;
+    }
+
+    constexpr size_t n = 1000000;
+    auto const params = MainnetParams();
+
+    CChainStore chain(0);
+    chain.reserve(n);
+    int64_t nTime = 1605447844;
+    chain.push_back(uint32_t(nTime), 0x1804dafe);
+    for (size_t i = 1; i < n; ++i) {
+        nTime += 600 + int64_t(rng() % 1201) - 600;
+        chain.push_back(uint32_t(nTime), GetNextASERTWorkRequired(chain, int(i) - 1, 0, params));
+    }
+
+    for (size_t t = 0; t < threadCounts.size(); ++t) {
+        if ( ! Selected(labels[t].c_str())) {
+            continue;
+        }
+        unsigned int const nThreads = threadCounts[t];
+        Result const r = Measure(5, [&](size_t) {
+            DoNotOptimize(FindFirstASERTBitsMismatch(chain, 0, 1, params, nThreads));
+        });
+        Print(labels[t].c_str(), r.PerCall(n));
+    }
+}
+
+// Chain work of one million blocks whose nBits changes every block, as it
+// does under ASERT.
+void BenchChainWork(std::mt19937_64& rng) {
+    unsigned int const nHardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<unsigned int> threadCounts = {1u};
+    if (nHardwareThreads > 1) {
+        threadCounts.push_back(nHardwareThreads);
+    }
+    std::vector<std::string> labels;
+    for (unsigned int nThreads : threadCounts) {
+        labels.push_back("ComputeChainWork, 1M, " + std::to_string(nThreads) + " threads");
+    }
+    if ( ! AnySelected(labels)) {
+        return;
+    }
+
+    constexpr size_t n = 1000000;
+    std::vector<uint32_t> bits(n);
+    for (auto& nBits : bits) {
+        nBits = 0x18000000 | uint32_t(0x008000 + rng() % 0x7f8000);
+    }
+    std::vector<arith_uint256> chainWork(n);
+
+    for (size_t t = 0; t < threadCounts.size(); ++t) {
+        if ( ! Selected(labels[t].c_str())) {
+            continue;
+        }
+        unsigned int const nThreads = threadCounts[t];
+        Result const r = Measure(5, [&](size_t) {
+            ComputeChainWork(bits.data(), n, arith_uint256(), chainWork.data(), nThreads);
+            DoNotOptimize(chainWork[n - 1]);
+        });
+        Print(labels[t].c_str(), r.PerCall(n));
+    }
+}
+
+// Double SHA-256 and proof-of-work check of 64k random headers with the
+// easiest nBits below a powLimit of all ones. The few headers whose hash
+// misses that target get a new nonce, so the whole batch is checked.
+void BenchProofOfWork(std::mt19937_64& rng) {
+    std::string const kernel = SHA256dKernelName();
+    std::vector<std::string> const labels = {
+        "SHA256dHeaders 64k (" + kernel + ")",
+        "FindFirstInvalidProofOfWork 64k (" + kernel + ")",
+    };
+    if ( ! AnySelected(labels)) {
+        return;
+    }
+
+    constexpr size_t n = 65536;
+    auto params = MainnetParams();
+    params.powLimit = uint256S("ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff");
+
+    std::vector<uint8_t> headers(n * CBlockHeaderView::SIZE);
+    for (auto& byte : headers) {
+        byte = uint8_t(rng());
+    }
+    for (size_t i = 0; i < n; ++i) {
+        WriteLE32(&headers[i * CBlockHeaderView::SIZE + 72], 0x2100ffff);
+    }
+    for (size_t i; (i = FindFirstInvalidProofOfWork(headers.data(), n, params)) < n;) {
+        WriteLE32(&headers[i * CBlockHeaderView::SIZE + 76], uint32_t(rng()));
+    }
+    std::vector<uint8_t> hashes(n * 32);
+
+    if (Selected(labels[0].c_str())) {
+        Result const r = Measure(10, [&](size_t) {
+            SHA256dHeaders(headers.data(), n, hashes.data());
+            DoNotOptimize(hashes[0]);
+        });
+        Print(labels[0].c_str(), r.PerCall(n));
+    }
+    if (Selected(labels[1].c_str())) {
+        Result const r = Measure(10, [&](size_t) {
+            DoNotOptimize(FindFirstInvalidProofOfWork(headers.data(), n, params));
+        });
+        Print(labels[1].c_str(), r.PerCall(n));
+    }
+}
+
+// GetAncestor on a one million block chain, from random tips down to a fixed
+// depth below them, with the skip list built and with pprev links only.
+void BenchAncestor(std::mt19937_64& rng) {
+    constexpr int n = 1000000;
+    int const depths[] = {1, 10, 100, 1000, 10000, 100000, n - 1};
+    std::vector<std::string> labels;
+    for (int depth : depths) {
+        labels.push_back("GetAncestor(tip - " + std::to_string(depth) + "), skip list");
+        labels.push_back("GetAncestor(tip - " + std::to_string(depth) + "), pprev only");
+    }
+    if ( ! AnySelected(labels)) {
+        return;
+    }
+
+    std::vector<CBlockIndex> skipped(n);
+    std::vector<CBlockIndex> linked(n);
+    for (int i = 0; i < n; ++i) {
+        skipped[i].nHeight = linked[i].nHeight = i;
+        if (i > 0) {
+            skipped[i].pprev = &skipped[i - 1];
+            linked[i].pprev = &linked[i - 1];
+        }
+        skipped[i].BuildSkip();
+    }
+
+    constexpr size_t m = 1024;
+    constexpr size_t mask = m - 1;
+    for (size_t d = 0; d < std::size(depths); ++d) {
+        int const depth = depths[d];
+        std::vector<int> tips(m);
+        for (auto& tip : tips) {
+            tip = depth + int(rng() % (n - depth));
+        }
+
+        Bench(labels[2 * d].c_str(), 200000, [&](size_t i) {
+            int const tip = tips[i & mask];
+            DoNotOptimize(skipped[tip].GetAncestor(tip - depth));
+        });
+
+        Bench(labels[2 * d + 1].c_str(), std::max<size_t>(10, 20000000 / depth), [&](size_t i) {
+            int const tip = tips[i & mask];
+            DoNotOptimize(linked[tip].GetAncestor(tip - depth));
+        });
+    }
+}
+
+// Unit exponential variates: the standard library one at a time against
+// Philox4x32 one at a time and in batches.
+void BenchRandom() {
+    constexpr size_t n = 1024;
+    std::vector<double> out(n);
+
+    std::mt19937_64 mt(42);
+    std::exponential_distribution<double> exponential;
+    Bench("std::exponential_distribution(mt19937_64) x1024", 20000, [&](size_t) {
+        for (auto& x : out) {
+            x = exponential(mt);
+        }
+        DoNotOptimize(out[0]);
+    });
+
+    Philox4x32 philox(42, 0);
+    Bench("-log(1 - Philox4x32::Uniform()) x1024", 20000, [&](size_t) {
+        for (auto& x : out) {
+            x = -std::log(1 - philox.Uniform());
+        }
+        DoNotOptimize(out[0]);
+    });
+
+    char label[96];
+    std::snprintf(label, sizeof(label), "SampleExponential 1024 (%s)", SampleExponentialKernelName());
+    Bench(label, 20000, [&](size_t) {
+        SampleExponential(philox, out.data(), n);
+        DoNotOptimize(out[0]);
+    });
+}
+
+void WriteJSONString(std::FILE* out, std::string const& s) {
+    std::fputc('"', out);
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            std::fputc('\\', out);
+        }
+        std::fputc(c, out);
+    }
+    std::fputc('"', out);
+}
+
+// Google Benchmark's JSON layout, plus the TSC cycles per iteration.
+void WriteJSON(std::FILE* out, char const* executable) {
+    char date[32];
+    std::time_t const now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", std::localtime(&now));
+
+    std::fprintf(out, "{\n  \"context\": {\n    \"date\": ");
+    WriteJSONString(out, date);
+    std::fprintf(out, ",\n    \"executable\": ");
+    WriteJSONString(out, executable);
+    std::fprintf(out, ",\n    \"num_cpus\": %u,\n", std::thread::hardware_concurrency());
+#ifdef NDEBUG
+    std::fprintf(out, "    \"library_build_type\": \"release\"\n  },\n");
+#else
+    std::fprintf(out, "    \"library_build_type\": \"debug\"\n  },\n");
+#endif
+    std::fprintf(out, "  \"benchmarks\": [");
+    for (size_t i = 0; i < records.size(); ++i) {
+        Result const& r = records[i].result;
+        std::fprintf(out, "%s\n    {\n      \"name\": ", i == 0 ? "" : ",");
+        WriteJSONString(out, records[i].name);
+        std::fprintf(out, ",\n      \"run_type\": \"iteration\",\n");
+        std::fprintf(out, "      \"iterations\": %zu,\n", r.iterations);
+        std::fprintf(out, "      \"real_time\": %.4f,\n", r.ns);
+        std::fprintf(out, "      \"cpu_time\": %.4f,\n", r.cpuNs);
+        std::fprintf(out, "      \"time_unit\": \"ns\",\n");
+        std::fprintf(out, "      \"cycles\": %.4f\n    }", r.cycles);
+    }
+    std::fprintf(out, "\n  ]\n}\n");
+}
+
+bool ParseOption(char const* arg, char const* option, char const*& value) {
+    size_t const len = std::strlen(option);
+    if (std::strncmp(arg, option, len) != 0 || arg[len] != '=') {
+        return false;
+    }
+    value = arg + len + 1;
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    char const* outPath = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        char const* value;
+        if (ParseOption(argv[i], "--benchmark_filter", value)) {
+            filter = std::regex(value);
+        } else if (ParseOption(argv[i], "--benchmark_format", value) &&
+                   (std::strcmp(value, "console") == 0 || std::strcmp(value, "json") == 0)) {
+            fConsole = std::strcmp(value, "console") == 0;
+        } else if (ParseOption(argv[i], "--benchmark_out", value)) {
+            outPath = value;
+        } else {
+            std::fprintf(stderr, "usage: %s [--benchmark_filter=<regex>] [--benchmark_format=<console|json>] "
+                                 "[--benchmark_out=<file>]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    std::mt19937_64 rng(42);
+    BenchArith(rng);
+    BenchBlockProof(rng);
+    BenchMulShift(rng);
+    BenchShifts(rng);
+    BenchCompact(rng);
+    BenchCalculateASERT(rng);
+    BenchNextWorkRequired(rng);
+    BenchChainStore(rng);
+    BenchValidation(rng);
+    BenchChainWork(rng);
+    BenchProofOfWork(rng);
+    BenchAncestor(rng);
+    BenchRandom();
+
+    if ( ! fConsole) {
+        WriteJSON(stdout, argv[0]);
+    }
+    if (outPath != nullptr) {
+        std::FILE* out = std::fopen(outPath, "w");
+        if (out == nullptr) {
+            std::perror(outPath);
+            return 1;
+        }
+        WriteJSON(out, argv[0]);
+        std::fclose(out);
+    }
+    return 0;
+}
@@ -2,8 +2,18 @@
 
 #include <stdint.h>
 
+#include <cstdio>
+#include <exception>
+#include <optional>
+#include <shared_mutex>
+
 #include "aserti3-416_capi.h"
 #include "aserti3-416.hpp"
+#include "aserti3-416_daa.hpp"
+#include "aserti3-416_headers.hpp"
+#include "aserti3-416_pow.hpp"
+#include "aserti3-416_simul.hpp"
+#include "aserti3-416_validation.hpp"
 
 extern "C" {  
 
@@ -55,6 +65,19 @@ void CAPI_CBlockIndex_set_pprev(void* ptr, void* pprev_ptr) {
     static_cast<CBlockIndex*>(ptr)->pprev = static_cast<CBlockIndex*>(pprev_ptr);
 }
 
+void CAPI_CBlockIndex_link(void* ptr, void* pprev_ptr) {
+    auto* obj = static_cast<CBlockIndex*>(ptr);
+    obj->pprev = static_cast<CBlockIndex*>(pprev_ptr);
+    if (obj->pprev != nullptr) {
+        obj->nHeight = obj->pprev->nHeight + 1;
+    }
+    obj->BuildSkip();
+}
+
+void* CAPI_CBlockIndex_GetAncestor(void* ptr, int height) {
+    return static_cast<CBlockIndex*>(ptr)->GetAncestor(height);
+}
+
 //                                              arith_uint256
 void CAPI_CBlockIndex_set_nChainWork(void* ptr, void* nChainWork) {
     static_cast<CBlockIndex*>(ptr)->nChainWork = *static_cast<arith_uint256*>(nChainWork);
@@ -155,6 +178,22 @@ void CAPI_Params_destruct(void* ptr) {
     delete obj;
 }
 
+void CAPI_Params_set_powLimit(void* ptr, uint32_t nCompact) {
+    static_cast<Consensus::Params*>(ptr)->powLimit = ArithToUint256(arith_uint256().SetCompact(nCompact));
+}
+
+void CAPI_Params_set_nDAAHalfLife(void* ptr, int64_t nDAAHalfLife) {
+    static_cast<Consensus::Params*>(ptr)->nDAAHalfLife = nDAAHalfLife;
+}
+
+void CAPI_Params_set_nPowTargetSpacing(void* ptr, int64_t nPowTargetSpacing) {
+    static_cast<Consensus::Params*>(ptr)->nPowTargetSpacing = nPowTargetSpacing;
+}
+
+void CAPI_Params_set_fPowAllowMinDifficultyBlocks(void* ptr, int fPowAllowMinDifficultyBlocks) {
+    static_cast<Consensus::Params*>(ptr)->fPowAllowMinDifficultyBlocks = fPowAllowMinDifficultyBlocks != 0;
+}
+
 
 // CAPI_GetNextASERTWorkRequired --------------------------------------------------------
 uint32_t CAPI_GetNextASERTWorkRequired(void const* pindexPrev,
@@ -171,6 +210,50 @@ uint32_t CAPI_GetNextASERTWorkRequired(void const* pindexPrev,
     return GetNextASERTWorkRequired(pindexPrev_cpp, pblock_cpp, params_cpp, pindexReferenceBlock_cpp, debugASERT);
 }
 
+void const* CAPI_GetSuitableBlock(void const* pindex) {
+    return GetSuitableBlock(static_cast<CBlockIndex const*>(pindex));
+}
+
+uint32_t CAPI_GetNextASERTMo3WorkRequired(void const* pindexPrev,
+                                          void const* pblock,
+                                          void const* params,
+                                          void const* pindexAnchor,
+                                          int debugASERT) {
+
+    CBlockIndex const* pindexPrev_cpp = static_cast<CBlockIndex const*>(pindexPrev);
+    CBlockHeader const* pblock_cpp = static_cast<CBlockHeader const*>(pblock);
+    Consensus::Params const& params_cpp = *static_cast<Consensus::Params const*>(params);
+    CBlockIndex const* pindexAnchor_cpp = static_cast<CBlockIndex const*>(pindexAnchor);
+
+    return GetNextASERTMo3WorkRequired(pindexPrev_cpp, pblock_cpp, params_cpp, pindexAnchor_cpp, debugASERT);
+}
+
+int CAPI_CalculateASERTBatch(uint32_t nRefBits,
+                             int64_t const* nTimeDiffs,
+                             int64_t const* nHeightDiffs,
+                             size_t count,
+                             void const* params,
+                             uint32_t* nBitsOut) {
+
+    Consensus::Params const& params_cpp = *static_cast<Consensus::Params const*>(params);
+
+    // What CalculateASERTBatch asserts, checked instead of aborting.
+    bool fNegative;
+    bool fOverflow;
+    arith_uint256 const refTarget = arith_uint256().SetCompact(nRefBits, &fNegative, &fOverflow);
+    if (fNegative || fOverflow || refTarget == 0 || refTarget > UintToArith256(params_cpp.powLimit)) {
+        return 0;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        if (nHeightDiffs[i] < 0) {
+            return 0;
+        }
+    }
+
+    CalculateASERTBatch(nRefBits, nTimeDiffs, nHeightDiffs, count, params_cpp, nBitsOut);
+    return 1;
+}
+
 
 // uint32_t CAPI_GetNextASERTWorkRequired(void const* pindexPrev,
 //                                   void const* pblock,
@@ -184,4 +267,291 @@ uint32_t CAPI_GetNextASERTWorkRequired(void const* pindexPrev,
 //     return GetNextASERTWorkRequired(pindexPrev_cpp, pblock_cpp, params_cpp, nforkHeight);
 // }
 
+
+// class ASERTChain --------------------------------------------------------
+
+// Persistent chain used by simulators that feed one block at a time.
+// ASERT only needs the reference block and the previous block, so only the
+// ASERTContext of the reference block and the tip are kept resident:
+// appending a block and asking for the next target are O(1) regardless of
+// the chain length, with no compact decoding per block.
+// The first appended block becomes the reference block.
+struct ASERTChain {
+    explicit ASERTChain(Consensus::Params const& params)
+        : params(params)
+    {}
+
+    Consensus::Params params;
+    std::optional<ASERTContext> context;
+    int nTipHeight = 0;
+    int64_t nTipTime = 0;
+};
+
+void* CAPI_ASERTChain_construct(void const* params) {
+    return new ASERTChain(*static_cast<Consensus::Params const*>(params));
+}
+
+void CAPI_ASERTChain_destruct(void* ptr) {
+    auto* obj = static_cast<ASERTChain*>(ptr);
+    delete obj;
+}
+
+void CAPI_ASERTChain_append(void* ptr, int nHeight, uint32_t nTime, uint32_t nBits) {
+    auto* obj = static_cast<ASERTChain*>(ptr);
+    if ( ! obj->context) {
+        obj->context.emplace(nHeight, nTime, nBits, obj->params);
+    }
+    obj->nTipHeight = nHeight;
+    obj->nTipTime = nTime;
+}
+
+uint32_t CAPI_ASERTChain_next_work_required(void const* ptr) {
+    auto const* obj = static_cast<ASERTChain const*>(ptr);
+    if ( ! obj->context) {
+        return 0;
+    }
+    return obj->context->next(obj->nTipTime, obj->nTipHeight);
+}
+
+// class CChainStore --------------------------------------------------------
+// A chain store and the lock its callers share, see CAPI_ChainStore_lock().
+struct ChainStore {
+    ChainStore(int nFirstHeight, bool fChainWork)
+        : chain(nFirstHeight, fChainWork)
+    {}
+
+    CChainStore chain;
+    mutable std::shared_mutex mutex;
+};
+
+void* CAPI_ChainStore_construct(int nFirstHeight, int fChainWork) {
+    return new ChainStore(nFirstHeight, fChainWork != 0);
+}
+
+void CAPI_ChainStore_destruct(void* ptr) {
+    auto* obj = static_cast<ChainStore*>(ptr);
+    delete obj;
+}
+
+void CAPI_ChainStore_lock_shared(void const* ptr) {
+    static_cast<ChainStore const*>(ptr)->mutex.lock_shared();
+}
+
+void CAPI_ChainStore_unlock_shared(void const* ptr) {
+    static_cast<ChainStore const*>(ptr)->mutex.unlock_shared();
+}
+
+void CAPI_ChainStore_lock(void* ptr) {
+    static_cast<ChainStore*>(ptr)->mutex.lock();
+}
+
+void CAPI_ChainStore_unlock(void* ptr) {
+    static_cast<ChainStore*>(ptr)->mutex.unlock();
+}
+
+void CAPI_ChainStore_push_back(void* ptr, uint32_t nTime, uint32_t nBits) {
+    static_cast<ChainStore*>(ptr)->chain.push_back(nTime, nBits);
+}
+
+void CAPI_ChainStore_append(void* ptr, uint32_t const* nTimes, uint32_t const* nBits, size_t count, unsigned int nThreads) {
+    static_cast<ChainStore*>(ptr)->chain.append(nTimes, nBits, count, nThreads);
+}
+
+void CAPI_ChainStore_truncate(void* ptr, int nHeight) {
+    static_cast<ChainStore*>(ptr)->chain.truncate(nHeight);
+}
+
+int CAPI_ChainStore_get_first_height(void const* ptr) {
+    return static_cast<ChainStore const*>(ptr)->chain.FirstHeight();
+}
+
+int CAPI_ChainStore_get_tip_height(void const* ptr) {
+    return static_cast<ChainStore const*>(ptr)->chain.TipHeight();
+}
+
+uint32_t CAPI_ChainStore_next_work_required(void const* ptr, int nPrevHeight, int nRefHeight, void const* params) {
+    CChainStore const& chain_cpp = static_cast<ChainStore const*>(ptr)->chain;
+    Consensus::Params const& params_cpp = *static_cast<Consensus::Params const*>(params);
+    return GetNextASERTWorkRequired(chain_cpp, nPrevHeight, nRefHeight, params_cpp);
+}
+
+int CAPI_ChainStore_get_suitable_height(void const* ptr, int nHeight) {
+    return GetSuitableBlockHeight(static_cast<ChainStore const*>(ptr)->chain, nHeight);
+}
+
+uint32_t CAPI_ChainStore_next_work_required_mo3(void const* ptr, int nPrevHeight, int nAnchorHeight, void const* params) {
+    CChainStore const& chain_cpp = static_cast<ChainStore const*>(ptr)->chain;
+    Consensus::Params const& params_cpp = *static_cast<Consensus::Params const*>(params);
+    return GetNextASERTMo3WorkRequired(chain_cpp, nPrevHeight, nAnchorHeight, params_cpp);
+}
+
+void CAPI_ChainStore_next_work_required_range(void const* ptr,
+                                              int nRefHeight,
+                                              int nFirstPrevHeight,
+                                              size_t count,
+                                              void const* params,
+                                              uint32_t* nBitsOut) {
+    CChainStore const& chain_cpp = static_cast<ChainStore const*>(ptr)->chain;
+    Consensus::Params const& params_cpp = *static_cast<Consensus::Params const*>(params);
+    GetNextASERTWorkRequiredRange(chain_cpp, nRefHeight, nFirstPrevHeight, count, params_cpp, nBitsOut);
+}
+
+int CAPI_ChainStore_find_first_bits_mismatch(void const* ptr,
+                                             int nRefHeight,
+                                             int nFirstHeight,
+                                             void const* params,
+                                             unsigned int nThreads) {
+    CChainStore const& chain_cpp = static_cast<ChainStore const*>(ptr)->chain;
+    Consensus::Params const& params_cpp = *static_cast<Consensus::Params const*>(params);
+    return FindFirstASERTBitsMismatch(chain_cpp, nRefHeight, nFirstHeight, params_cpp, nThreads);
+}
+
+int CAPI_ChainStore_load_headers(void* ptr, char const* path, char* error, size_t error_size) {
+    CChainStore& chain_cpp = static_cast<ChainStore*>(ptr)->chain;
+    try {
+        CHeaderFile const file(path);
+        AppendHeaders(chain_cpp, file);
+    } catch (std::exception const& e) {
+        std::snprintf(error, error_size, "%s", e.what());
+        return 0;
+    }
+    return 1;
+}
+
+void CAPI_ChainStore_append_headers(void* ptr, uint8_t const* headers, size_t count, unsigned int nThreads) {
+    AppendHeaders(static_cast<ChainStore*>(ptr)->chain, headers, count, nThreads);
+}
+
+void CAPI_ChainStore_enable_chain_work(void* ptr, unsigned int nThreads) {
+    static_cast<ChainStore*>(ptr)->chain.EnableChainWork(nThreads);
+}
+
+int CAPI_ChainStore_get_chain_work(void const* ptr, int nHeight, uint8_t* work_out) {
+    CChainStore const& chain_cpp = static_cast<ChainStore const*>(ptr)->chain;
+    if ( ! chain_cpp.HasChainWork()) {
+        return 0;
+    }
+    uint256 const work = ArithToUint256(chain_cpp.GetChainWork(nHeight));
+    memcpy(work_out, work.begin(), 32);
+    return 1;
+}
+
+void CAPI_GetBlockProof(uint32_t nBits, uint8_t* proof_out) {
+    uint256 const proof = ArithToUint256(GetBlockProof(nBits));
+    memcpy(proof_out, proof.begin(), 32);
+}
+
+// Proof of work -----------------------------------------------------------------
+void CAPI_SHA256d_headers(uint8_t const* headers, size_t count, uint8_t* hashes_out) {
+    SHA256dHeaders(headers, count, hashes_out);
+}
+
+size_t CAPI_Headers_find_first_invalid_pow(uint8_t const* headers, size_t count, void const* params) {
+    Consensus::Params const& params_cpp = *static_cast<Consensus::Params const*>(params);
+    return FindFirstInvalidProofOfWork(headers, count, params_cpp);
+}
+
+int CAPI_HeaderFile_find_first_invalid_pow(char const* path, void const* params, size_t* index_out, size_t* count_out, char* error, size_t error_size) {
+    Consensus::Params const& params_cpp = *static_cast<Consensus::Params const*>(params);
+    try {
+        CHeaderFile const file(path);
+        *index_out = FindFirstInvalidProofOfWork(file.data(), file.size(), params_cpp);
+        *count_out = file.size();
+    } catch (std::exception const& e) {
+        std::snprintf(error, error_size, "%s", e.what());
+        return 0;
+    }
+    return 1;
+}
+
+// Difficulty algorithms --------------------------------------------------------
+size_t CAPI_DAA_count() {
+    return GetDifficultyAlgorithmNames().size();
+}
+
+char const* CAPI_DAA_name(size_t i) {
+    // The registry owns the names for the lifetime of the program.
+    return GetDifficultyAlgorithm(GetDifficultyAlgorithmNames().at(i))->GetName().c_str();
+}
+
+void const* CAPI_DAA_get(char const* name) {
+    return GetDifficultyAlgorithm(name);
+}
+
+int CAPI_DAA_get_min_prev_height(void const* daa, void const* chain) {
+    return static_cast<DifficultyAlgorithm const*>(daa)->GetMinPrevHeight(static_cast<ChainStore const*>(chain)->chain);
+}
+
+uint32_t CAPI_DAA_next_work_required(void const* daa, void const* chain, int nPrevHeight, void const* params) {
+    DifficultyAlgorithm const& daa_cpp = *static_cast<DifficultyAlgorithm const*>(daa);
+    CChainStore const& chain_cpp = static_cast<ChainStore const*>(chain)->chain;
+    Consensus::Params const& params_cpp = *static_cast<Consensus::Params const*>(params);
+    return daa_cpp.GetNextWorkRequired(chain_cpp, nPrevHeight, params_cpp);
+}
+
+void CAPI_DAA_next_work_required_range(void const* daa,
+                                       void const* chain,
+                                       int nFirstPrevHeight,
+                                       size_t count,
+                                       void const* params,
+                                       uint32_t* nBitsOut) {
+    DifficultyAlgorithm const& daa_cpp = *static_cast<DifficultyAlgorithm const*>(daa);
+    CChainStore const& chain_cpp = static_cast<ChainStore const*>(chain)->chain;
+    Consensus::Params const& params_cpp = *static_cast<Consensus::Params const*>(params);
+    daa_cpp.GetNextWorkRequiredRange(chain_cpp, nFirstPrevHeight, count, params_cpp, nBitsOut);
+}
+
+// Simulation --------------------------------------------------------
+void* CAPI_SimulParams_construct() {
+    return new SimulParams();
+}
+
+void CAPI_SimulParams_destruct(void* ptr) {
+    auto* obj = static_cast<SimulParams*>(ptr);
+    delete obj;
+}
+
+int CAPI_SimulParams_set(void* ptr, char const* name, double value) {
+    return SetSimulParam(*static_cast<SimulParams*>(ptr), name, value);
+}
+
+int CAPI_SimulParams_set_algo(void* ptr, char const* name) {
+    DifficultyAlgorithm const* algo = GetDifficultyAlgorithm(name);
+    if (algo == nullptr) {
+        return 0;
+    }
+    static_cast<SimulParams*>(ptr)->algo = algo;
+    return 1;
+}
+
+int CAPI_RunSimulations(void const* simulParams,
+                        char const* scenario,
+                        void const* params,
+                        uint64_t seed,
+                        size_t count,
+                        unsigned int nThreads,
+                        double* summaryOut) {
+
+    SimulParams const& simul_cpp = *static_cast<SimulParams const*>(simulParams);
+    Consensus::Params const& params_cpp = *static_cast<Consensus::Params const*>(params);
+
+    SimulScenario scenario_cpp;
+    if ( ! GetSimulScenario(scenario, scenario_cpp)) {
+        return 0;
+    }
+    if (simul_cpp.nBlocks < 1 || simul_cpp.nVariableWindow < 1 || simul_cpp.nVariableWindow > 2020) {
+        return 0;
+    }
+
+    auto const summary = SummarizeSimulations(RunSimulations(simul_cpp, scenario_cpp, params_cpp, seed, count, nThreads));
+    for (SimulStat const& stat : {summary.mean, summary.stdev, summary.median, summary.max}) {
+        *summaryOut++ = stat.min;
+        *summaryOut++ = stat.max;
+        *summaryOut++ = stat.mean;
+        *summaryOut++ = stat.stdev;
+        *summaryOut++ = stat.median;
+    }
+    return 1;
+}
+
 } // extern "C"
@@ -16,6 +16,10 @@ int CAPI_CBlockIndex_get_nHeight(void* ptr);
 void CAPI_CBlockIndex_set_nTime(void* ptr, uint32_t nTime);
 void CAPI_CBlockIndex_set_nBits(void* ptr, uint32_t nBits);
 void CAPI_CBlockIndex_set_pprev(void* ptr, void* pprev_ptr);
+// pprev = pprev_ptr, nHeight = pprev's + 1 and builds pskip.
+void CAPI_CBlockIndex_link(void* ptr, void* pprev_ptr);
+// Null if there is no block at that height in the chain.
+void* CAPI_CBlockIndex_GetAncestor(void* ptr, int height);
 void CAPI_CBlockIndex_set_nChainWork(void* ptr, void* nChainWork);
 
 // class CBlockHeader --------------------------------------------------------
@@ -36,6 +40,10 @@ void* CAPI_arith_uint256_add(void* ptr, uint64_t b);
 // Parameters --------------------------------------------------------
 void* CAPI_Params_GetDefaultMainnetConsensusParams(void);
 void CAPI_Params_destruct(void* ptr);
+void CAPI_Params_set_powLimit(void* ptr, uint32_t nCompact);
+void CAPI_Params_set_nDAAHalfLife(void* ptr, int64_t nDAAHalfLife);
+void CAPI_Params_set_nPowTargetSpacing(void* ptr, int64_t nPowTargetSpacing);
+void CAPI_Params_set_fPowAllowMinDifficultyBlocks(void* ptr, int fPowAllowMinDifficultyBlocks);
 
 
 // CAPI_GetNextASERTWorkRequired --------------------------------------------------------
@@ -46,11 +54,125 @@ uint32_t CAPI_GetNextASERTWorkRequired(void const* pindexPrev,
                                   void const* pindexReferenceBlock,
                                   int debugASERT);
 
+void const* CAPI_GetSuitableBlock(void const* pindex);
+
+uint32_t CAPI_GetNextASERTMo3WorkRequired(void const* pindexPrev,
+                                          void const* pblock,
+                                          void const* params,
+                                          void const* pindexAnchor,
+                                          int debugASERT);
+
+// Returns 0, writing nothing, if nRefBits is not a target in (0, powLimit]
+// or a height diff is negative.
+int CAPI_CalculateASERTBatch(uint32_t nRefBits,
+                             int64_t const* nTimeDiffs,
+                             int64_t const* nHeightDiffs,
+                             size_t count,
+                             void const* params,
+                             uint32_t* nBitsOut);
+
 // uint32_t CAPI_GetNextASERTWorkRequired(const void* pindexPrev,
 //                                   const void* pblock,
 //                                   const void* params,
 //                                   const int32_t nforkHeight);
 
+// class ASERTChain --------------------------------------------------------
+void* CAPI_ASERTChain_construct(void const* params);
+void CAPI_ASERTChain_destruct(void* ptr);
+void CAPI_ASERTChain_append(void* ptr, int nHeight, uint32_t nTime, uint32_t nBits);
+// Returns 0, never a valid target, if no block has been appended yet.
+uint32_t CAPI_ASERTChain_next_work_required(void const* ptr);
+
+// class CChainStore --------------------------------------------------------
+void* CAPI_ChainStore_construct(int nFirstHeight, int fChainWork);
+void CAPI_ChainStore_destruct(void* ptr);
+// Reader-writer lock of the handle, for callers sharing a chain store across
+// threads: the functions below do not take it. Hold it shared around readers
+// (const handle) and exclusively around the others.
+void CAPI_ChainStore_lock_shared(void const* ptr);
+void CAPI_ChainStore_unlock_shared(void const* ptr);
+void CAPI_ChainStore_lock(void* ptr);
+void CAPI_ChainStore_unlock(void* ptr);
+void CAPI_ChainStore_push_back(void* ptr, uint32_t nTime, uint32_t nBits);
+// Appends count blocks, the chain work, if kept, computed on nThreads threads
+// (0: one per hardware thread).
+void CAPI_ChainStore_append(void* ptr, uint32_t const* nTimes, uint32_t const* nBits, size_t count, unsigned int nThreads);
+void CAPI_ChainStore_truncate(void* ptr, int nHeight);
+int CAPI_ChainStore_get_first_height(void const* ptr);
+int CAPI_ChainStore_get_tip_height(void const* ptr);
+uint32_t CAPI_ChainStore_next_work_required(void const* ptr, int nPrevHeight, int nRefHeight, void const* params);
+int CAPI_ChainStore_get_suitable_height(void const* ptr, int nHeight);
+uint32_t CAPI_ChainStore_next_work_required_mo3(void const* ptr, int nPrevHeight, int nAnchorHeight, void const* params);
+void CAPI_ChainStore_next_work_required_range(void const* ptr,
+                                              int nRefHeight,
+                                              int nFirstPrevHeight,
+                                              size_t count,
+                                              void const* params,
+                                              uint32_t* nBitsOut);
+// Lowest height in [nFirstHeight, tip] whose nBits is not the ASERT one, -1 if none.
+int CAPI_ChainStore_find_first_bits_mismatch(void const* ptr,
+                                             int nRefHeight,
+                                             int nFirstHeight,
+                                             void const* params,
+                                             unsigned int nThreads);
+// Appends the headers of a raw header dump (80 byte serialized headers, back
+// to back). Returns 0 and writes a message to error if the file cannot be read.
+int CAPI_ChainStore_load_headers(void* ptr, char const* path, char* error, size_t error_size);
+// Appends count 80 byte serialized headers, back to back.
+void CAPI_ChainStore_append_headers(void* ptr, uint8_t const* headers, size_t count, unsigned int nThreads);
+// Starts keeping chain work, computed for the blocks already in the store on
+// nThreads threads (0: one per hardware thread).
+void CAPI_ChainStore_enable_chain_work(void* ptr, unsigned int nThreads);
+// Chain work of the block at nHeight as 32 little endian bytes to work_out.
+// Returns 0 if the store does not keep chain work.
+int CAPI_ChainStore_get_chain_work(void const* ptr, int nHeight, uint8_t* work_out);
+
+// Block proof as 32 little endian bytes to proof_out.
+void CAPI_GetBlockProof(uint32_t nBits, uint8_t* proof_out);
+
+// Proof of work -----------------------------------------------------------------
+// Double SHA-256 of count 80 byte serialized headers, 32 bytes each to hashes_out.
+void CAPI_SHA256d_headers(uint8_t const* headers, size_t count, uint8_t* hashes_out);
+// Index of the first of count serialized headers failing CheckProofOfWork,
+// count if none does.
+size_t CAPI_Headers_find_first_invalid_pow(uint8_t const* headers, size_t count, void const* params);
+// Same for a raw header dump, to *index_out, with the number of headers in the
+// file to *count_out. Returns 0 and writes a message to error if the file
+// cannot be read.
+int CAPI_HeaderFile_find_first_invalid_pow(char const* path, void const* params, size_t* index_out, size_t* count_out, char* error, size_t error_size);
+
+// Difficulty algorithms --------------------------------------------------------
+size_t CAPI_DAA_count(void);
+char const* CAPI_DAA_name(size_t i);
+// Null if there is no algorithm of that name.
+void const* CAPI_DAA_get(char const* name);
+int CAPI_DAA_get_min_prev_height(void const* daa, void const* chain);
+uint32_t CAPI_DAA_next_work_required(void const* daa, void const* chain, int nPrevHeight, void const* params);
+void CAPI_DAA_next_work_required_range(void const* daa,
+                                       void const* chain,
+                                       int nFirstPrevHeight,
+                                       size_t count,
+                                       void const* params,
+                                       uint32_t* nBitsOut);
+
+// Simulation --------------------------------------------------------
+void* CAPI_SimulParams_construct(void);
+void CAPI_SimulParams_destruct(void* ptr);
+int CAPI_SimulParams_set(void* ptr, char const* name, double value);
+// Returns 0 if the algorithm is not registered (see CAPI_DAA_name).
+int CAPI_SimulParams_set_algo(void* ptr, char const* name);
+
+// Writes to summaryOut the mean, stdev, median and max block time
+// distributions across runs, each as min, max, mean, stdev, median (20 values).
+// Returns 0 if the scenario is unknown or the parameters are out of range.
+int CAPI_RunSimulations(void const* simulParams,
+                        char const* scenario,
+                        void const* params,
+                        uint64_t seed,
+                        size_t count,
+                        unsigned int nThreads,
+                        double* summaryOut);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
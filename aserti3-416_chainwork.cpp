@@ -0,0 +1,103 @@
+/**
+ * Copyright (c) 2020 Fernando Pelliccioni
+ */
+
+// Bulk block proofs and chain work, see GetBlockProofs() and
+// ComputeChainWork() in aserti3-416.hpp.
+//
+// The chain work is an inclusive prefix sum of the proofs. Each chunk's proofs
+// are summed locally in parallel, the chunk totals are scanned serially (one
+// addition per chunk), and the chunk offsets are then added in parallel.
+// Addition modulo 2^256 is associative, so the result is the serial sum's.
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "aserti3-416.hpp"
+
+namespace {
+
+// Blocks per work item: the division dominates, so a chunk of a few
+// milliseconds amortizes the scheduling.
+constexpr size_t chunkSize = 16384;
+
+// Runs f(chunk) for every chunk on nThreads threads, the caller being one.
+template <typename F>
+void ForEachChunk(size_t nChunks, unsigned int nThreads, F f) {
+    std::atomic<size_t> next {0};
+    auto worker = [&]() {
+        for (size_t chunk = next++; chunk < nChunks; chunk = next++) {
+            f(chunk);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned int i = 1; i < nThreads; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto &thread : threads) {
+        thread.join();
+    }
+}
+
+// chainWorkOut[i] = nBaseWork + proofs of nBits[0..i], on the calling thread.
+void ScanChainWork(const uint32_t *nBits, size_t count, const arith_uint256 &nBaseWork,
+                   arith_uint256 *chainWorkOut) {
+    arith_uint256 work = nBaseWork;
+    arith_uint256 proof;
+    for (size_t i = 0; i < count; ++i) {
+        if (i == 0 || nBits[i] != nBits[i - 1]) {
+            proof = GetBlockProof(nBits[i]);
+        }
+        work += proof;
+        chainWorkOut[i] = work;
+    }
+}
+
+} // namespace
+
+void GetBlockProofs(const uint32_t *nBits, size_t count, arith_uint256 *proofsOut) {
+    for (size_t i = 0; i < count; ++i) {
+        proofsOut[i] = i > 0 && nBits[i] == nBits[i - 1] ? proofsOut[i - 1] : GetBlockProof(nBits[i]);
+    }
+}
+
+void ComputeChainWork(const uint32_t *nBits,
+                      size_t count,
+                      const arith_uint256 &nBaseWork,
+                      arith_uint256 *chainWorkOut,
+                      unsigned int nThreads) {
+    const size_t nChunks = (count + chunkSize - 1) / chunkSize;
+    if (nThreads == 0) {
+        nThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    nThreads = unsigned(std::min<size_t>(nThreads, nChunks));
+    if (nThreads <= 1) {
+        ScanChainWork(nBits, count, nBaseWork, chainWorkOut);
+        return;
+    }
+
+    // The first chunk starts from nBaseWork, the others from zero.
+    ForEachChunk(nChunks, nThreads, [&](size_t chunk) {
+        const size_t begin = chunk * chunkSize;
+        const size_t n = std::min(chunkSize, count - begin);
+        ScanChainWork(nBits + begin, n, chunk == 0 ? nBaseWork : arith_uint256(), chainWorkOut + begin);
+    });
+
+    std::vector<arith_uint256> offsets(nChunks);
+    for (size_t chunk = 1; chunk < nChunks; ++chunk) {
+        offsets[chunk] = offsets[chunk - 1] + chainWorkOut[chunk * chunkSize - 1];
+    }
+
+    ForEachChunk(nChunks - 1, nThreads, [&](size_t chunk) {
+        const size_t begin = (chunk + 1) * chunkSize;
+        const size_t n = std::min(chunkSize, count - begin);
+        const arith_uint256 &offset = offsets[chunk + 1];
+        for (size_t i = 0; i < n; ++i) {
+            chainWorkOut[begin + i] += offset;
+        }
+    });
+}
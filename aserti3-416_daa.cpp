@@ -0,0 +1,277 @@
+/**
+ * Copyright (c) 2020 Fernando Pelliccioni
+ */
+
+// Difficulty adjustment algorithms other than ASERT, and the registry that
+// puts them behind a common interface with the ASERT variants.
+//
+// Each algorithm implements a non-virtual Next(); DifficultyAlgorithmImpl
+// turns it into the virtual interface, so a range costs one virtual call.
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+
+#include "aserti3-416_daa.hpp"
+
+namespace {
+
+template <typename Derived>
+class DifficultyAlgorithmImpl : public DifficultyAlgorithm {
+public:
+    using DifficultyAlgorithm::DifficultyAlgorithm;
+
+    uint32_t GetNextWorkRequired(const CChainStore &chain,
+                                 int nPrevHeight,
+                                 const Consensus::Params &params) const noexcept override {
+        assert(nPrevHeight >= GetMinPrevHeight(chain) && chain.Contains(nPrevHeight));
+        return static_cast<const Derived &>(*this).Next(chain, nPrevHeight, params);
+    }
+
+    void GetNextWorkRequiredRange(const CChainStore &chain,
+                                  int nFirstPrevHeight,
+                                  size_t count,
+                                  const Consensus::Params &params,
+                                  uint32_t *nBitsOut) const noexcept override {
+        if (count == 0) {
+            return;
+        }
+        assert(nFirstPrevHeight >= GetMinPrevHeight(chain));
+        assert(chain.Contains(nFirstPrevHeight + int(count) - 1));
+        const Derived &derived = static_cast<const Derived &>(*this);
+        for (size_t i = 0; i < count; ++i) {
+            nBitsOut[i] = derived.Next(chain, nFirstPrevHeight + int(i), params);
+        }
+    }
+};
+
+// The reference block is the first block of the store; for median of three
+// it is the anchor, whose two predecessors must be in the store too.
+class ASERTAlgorithm final : public DifficultyAlgorithmImpl<ASERTAlgorithm> {
+public:
+    ASERTAlgorithm(std::string name, const ASERTiVariant &variant)
+        : DifficultyAlgorithmImpl(std::move(name))
+        , variant(variant)
+    {}
+
+    int GetMinPrevHeight(const CChainStore &chain) const noexcept override {
+        return AnchorHeight(chain);
+    }
+
+    const ASERTiVariant *GetASERTiVariant() const noexcept override {
+        return &variant;
+    }
+
+    uint32_t Next(const CChainStore &chain, int nPrevHeight, const Consensus::Params &params) const noexcept {
+        return GetNextASERTiWorkRequired(variant, chain, nPrevHeight, AnchorHeight(chain), params);
+    }
+
+    // Plain order 3 variants go through the vectorized batch.
+    void GetNextWorkRequiredRange(const CChainStore &chain,
+                                  int nFirstPrevHeight,
+                                  size_t count,
+                                  const Consensus::Params &params,
+                                  uint32_t *nBitsOut) const noexcept override {
+        if (variant.nOrder != 3 || variant.fMedianOfThree) {
+            DifficultyAlgorithmImpl::GetNextWorkRequiredRange(chain, nFirstPrevHeight, count, params, nBitsOut);
+            return;
+        }
+        Consensus::Params asertParams = params;
+        if (variant.nHalfLife != 0) {
+            asertParams.nDAAHalfLife = variant.nHalfLife;
+        }
+        GetNextASERTWorkRequiredRange(chain, AnchorHeight(chain), nFirstPrevHeight, count, asertParams, nBitsOut);
+    }
+
+private:
+    int AnchorHeight(const CChainStore &chain) const noexcept {
+        return chain.FirstHeight() + (variant.fMedianOfThree ? 2 : 0);
+    }
+
+    ASERTiVariant variant;
+};
+
+// Weighted-target exponential moving average with alpha = 1 / N:
+//     next_target = prev_target / (T * N) * (block_time + T * (N - 1))
+// The factor is kept at least 1 so that a very negative block time cannot
+// make the target vanish.
+class WTEMAAlgorithm final : public DifficultyAlgorithmImpl<WTEMAAlgorithm> {
+public:
+    WTEMAAlgorithm(std::string name, int64_t nAlphaRecip)
+        : DifficultyAlgorithmImpl(std::move(name))
+        , nAlphaRecip(nAlphaRecip)
+    {}
+
+    int GetMinPrevHeight(const CChainStore &chain) const noexcept override {
+        return chain.FirstHeight() + 1;
+    }
+
+    uint32_t Next(const CChainStore &chain, int nPrevHeight, const Consensus::Params &params) const noexcept {
+        const arith_uint256 powLimit = UintToArith256(params.powLimit);
+        const int64_t nBlockTime = chain.GetBlockTime(nPrevHeight) - chain.GetBlockTime(nPrevHeight - 1);
+        const int64_t nFactor = std::max<int64_t>(1, std::min<int64_t>(
+            UINT32_MAX, nBlockTime + params.nPowTargetSpacing * (nAlphaRecip - 1)));
+
+        arith_uint256 nextTarget = arith_uint256().SetCompact(chain.GetBits(nPrevHeight));
+        nextTarget /= arith_uint256(uint64_t(params.nPowTargetSpacing * nAlphaRecip));
+        nextTarget *= uint32_t(nFactor);
+
+        if (nextTarget == 0) {
+            return arith_uint256(1).GetCompact();
+        }
+        if (nextTarget > powLimit) {
+            return powLimit.GetCompact();
+        }
+        return nextTarget.GetCompact();
+    }
+
+private:
+    int64_t nAlphaRecip;
+};
+
+// https://gitlab.com/bitcoin-cash-node/bitcoin-cash-node/-/blob/v0.21.0/src/pow.cpp#L126
+// BCH's November 2017 DAA: the work done between the suitable blocks of the
+// tip and of 144 blocks earlier, over their time span clamped to [72, 288]
+// block intervals. Without chain work in the store, the work is summed from
+// the targets.
+class CW144Algorithm final : public DifficultyAlgorithmImpl<CW144Algorithm> {
+public:
+    using DifficultyAlgorithmImpl::DifficultyAlgorithmImpl;
+
+    int GetMinPrevHeight(const CChainStore &chain) const noexcept override {
+        return chain.FirstHeight() + 144 + 2;
+    }
+
+    bool NeedsChainWork() const noexcept override { return true; }
+
+    uint32_t Next(const CChainStore &chain, int nPrevHeight, const Consensus::Params &params) const noexcept {
+        const int nLastHeight = GetSuitableBlockHeight(chain, nPrevHeight);
+        const int nFirstHeight = GetSuitableBlockHeight(chain, nPrevHeight - 144);
+        assert(nLastHeight > nFirstHeight);
+
+        arith_uint256 work;
+        if (chain.HasChainWork()) {
+            work = chain.GetChainWork(nLastHeight);
+            work -= chain.GetChainWork(nFirstHeight);
+        } else {
+            for (int nHeight = nFirstHeight + 1; nHeight <= nLastHeight; ++nHeight) {
+                work += GetBlockProof(chain.GetBits(nHeight));
+            }
+        }
+
+        // In order to avoid difficulty cliffs, we bound the amplitude of the
+        // adjustment we are going to do to a factor in [0.5, 2].
+        work *= uint32_t(params.nPowTargetSpacing);
+        int64_t nActualTimespan = chain.GetBlockTime(nLastHeight) - chain.GetBlockTime(nFirstHeight);
+        if (nActualTimespan > 288 * params.nPowTargetSpacing) {
+            nActualTimespan = 288 * params.nPowTargetSpacing;
+        } else if (nActualTimespan < 72 * params.nPowTargetSpacing) {
+            nActualTimespan = 72 * params.nPowTargetSpacing;
+        }
+        work /= arith_uint256(uint64_t(nActualTimespan));
+
+        // We need to compute T = (2^256 / W) - 1 but 2^256 doesn't fit in 256
+        // bits. By expressing 1 as W / W, we get (2^256 - W) / W, and we can
+        // compute 2^256 - W as the complement of W.
+        const arith_uint256 nextTarget = (-work) / work;
+        const arith_uint256 powLimit = UintToArith256(params.powLimit);
+        if (nextTarget > powLimit) {
+            return powLimit.GetCompact();
+        }
+        return nextTarget.GetCompact();
+    }
+};
+
+// https://github.com/zawy12/difficulty-algorithms/issues/3#issuecomment-442129791
+// LWMA-1: targets averaged over the last N blocks, times the solve times
+// weighted linearly from 1 (oldest) to N (newest). Timestamps are made
+// monotonic and solve times capped at 6 T.
+class LWMAAlgorithm final : public DifficultyAlgorithmImpl<LWMAAlgorithm> {
+public:
+    LWMAAlgorithm(std::string name, int nWindow)
+        : DifficultyAlgorithmImpl(std::move(name))
+        , nWindow(nWindow)
+    {}
+
+    int GetMinPrevHeight(const CChainStore &chain) const noexcept override {
+        return chain.FirstHeight() + nWindow;
+    }
+
+    uint32_t Next(const CChainStore &chain, int nPrevHeight, const Consensus::Params &params) const noexcept {
+        const int64_t T = params.nPowTargetSpacing;
+        const int64_t N = nWindow;
+        // Sum of the weights times T, so that the weighted mean solve time
+        // divided by k is 1 on schedule.
+        const int64_t k = N * (N + 1) * T / 2;
+        const arith_uint256 divisor(uint64_t(N * k));
+
+        arith_uint256 avgTarget;
+        int64_t nWeightedSum = 0;
+        int64_t nPreviousTime = chain.GetBlockTime(nPrevHeight - nWindow);
+        for (int j = 1; j <= nWindow; ++j) {
+            const int nHeight = nPrevHeight - nWindow + j;
+            const int64_t nThisTime = std::max(chain.GetBlockTime(nHeight), nPreviousTime + 1);
+            nWeightedSum += std::min(6 * T, nThisTime - nPreviousTime) * j;
+            nPreviousTime = nThisTime;
+            avgTarget += arith_uint256().SetCompact(chain.GetBits(nHeight)) / divisor;
+        }
+
+        assert(nWeightedSum > 0 && nWeightedSum <= int64_t(UINT32_MAX));
+        const arith_uint256 nextTarget = avgTarget * uint32_t(nWeightedSum);
+        const arith_uint256 powLimit = UintToArith256(params.powLimit);
+        if (nextTarget == 0) {
+            return arith_uint256(1).GetCompact();
+        }
+        if (nextTarget > powLimit) {
+            return powLimit.GetCompact();
+        }
+        return nextTarget.GetCompact();
+    }
+
+private:
+    int nWindow;
+};
+
+using Registry = std::vector<std::unique_ptr<DifficultyAlgorithm>>;
+
+Registry MakeRegistry() {
+    Registry registry;
+    for (const std::string &name : GetASERTiVariantNames()) {
+        ASERTiVariant variant;
+        GetASERTiVariant(name, variant);
+        registry.emplace_back(new ASERTAlgorithm(name, variant));
+    }
+    registry.emplace_back(new WTEMAAlgorithm("wtema-072", 72));
+    registry.emplace_back(new WTEMAAlgorithm("wtema-144", 144));
+    registry.emplace_back(new WTEMAAlgorithm("wtema-288", 288));
+    registry.emplace_back(new WTEMAAlgorithm("wtema-576", 576));
+    registry.emplace_back(new CW144Algorithm("cw-144"));
+    registry.emplace_back(new LWMAAlgorithm("lwma-045", 45));
+    registry.emplace_back(new LWMAAlgorithm("lwma-144", 144));
+    return registry;
+}
+
+const Registry &GetRegistry() {
+    static const Registry registry = MakeRegistry();
+    return registry;
+}
+
+} // namespace
+
+const DifficultyAlgorithm *GetDifficultyAlgorithm(const std::string &name) {
+    for (const auto &algorithm : GetRegistry()) {
+        if (algorithm->GetName() == name) {
+            return algorithm.get();
+        }
+    }
+    return nullptr;
+}
+
+std::vector<std::string> GetDifficultyAlgorithmNames() {
+    std::vector<std::string> names;
+    for (const auto &algorithm : GetRegistry()) {
+        names.push_back(algorithm->GetName());
+    }
+    return names;
+}
@@ -0,0 +1,71 @@
+#ifndef ASERTI3_416_DAA_HPP_
+#define ASERTI3_416_DAA_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "aserti3-416.hpp"
+
+/**
+ * A difficulty adjustment algorithm over a CChainStore: the compact target
+ * of the block after nPrevHeight, from the blocks at and below it.
+ * Instances are immutable and shared, see GetDifficultyAlgorithm().
+ */
+class DifficultyAlgorithm {
+public:
+    explicit DifficultyAlgorithm(std::string name)
+        : name(std::move(name))
+    {}
+    virtual ~DifficultyAlgorithm() = default;
+
+    /** Registry name, as in mining.py's Algos. */
+    const std::string &GetName() const { return name; }
+
+    /**
+     * Lowest nPrevHeight GetNextWorkRequired() accepts for chain: the blocks
+     * it reads must all be in the store.
+     */
+    virtual int GetMinPrevHeight(const CChainStore &chain) const noexcept = 0;
+
+    /** Whether the chain store must be built with chain work. */
+    virtual bool NeedsChainWork() const noexcept { return false; }
+
+    virtual uint32_t GetNextWorkRequired(const CChainStore &chain,
+                                         int nPrevHeight,
+                                         const Consensus::Params &params) const noexcept = 0;
+
+    /**
+     * nBitsOut[i] = GetNextWorkRequired(chain, nFirstPrevHeight + i, params)
+     * for i in [0, count), without a virtual call per block.
+     */
+    virtual void GetNextWorkRequiredRange(const CChainStore &chain,
+                                          int nFirstPrevHeight,
+                                          size_t count,
+                                          const Consensus::Params &params,
+                                          uint32_t *nBitsOut) const noexcept = 0;
+
+    /** The ASERT variant this algorithm is, nullptr if it is not ASERT. */
+    virtual const ASERTiVariant *GetASERTiVariant() const noexcept { return nullptr; }
+
+private:
+    std::string name;
+};
+
+/**
+ * Registered algorithms:
+ *  - every ASERT variant of GetASERTiVariant(), the reference block (or the
+ *    anchor, for median of three) being the first block of the store;
+ *  - wtema-<N>: weighted-target exponential moving average, alpha = 1 / N;
+ *  - cw-144: BCH's November 2017 DAA (GetNextCashWorkRequired);
+ *  - lwma-<N>: zawy's linearly weighted moving average, LWMA-1.
+ * Returns nullptr if name is unknown.
+ */
+const DifficultyAlgorithm *GetDifficultyAlgorithm(const std::string &name);
+
+/** Names of all the registered algorithms. */
+std::vector<std::string> GetDifficultyAlgorithmNames();
+
+#endif // ASERTI3_416_DAA_HPP_
@@ -0,0 +1,119 @@
+/**
+ * Copyright (c) 2020 Fernando Pelliccioni
+ */
+
+// Raw header dumps, see aserti3-416_headers.hpp.
+//
+// POSIX systems map the file, so loading is bounded by I/O rather than by
+// copying; elsewhere the file is read into a buffer once.
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#if defined(_WIN32)
+#include <fstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "aserti3-416_headers.hpp"
+
+namespace {
+
+[[noreturn]] void ThrowFileError(const std::string &path, const char *what) {
+    throw std::runtime_error(path + ": " + what);
+}
+
+} // namespace
+
+#if defined(_WIN32)
+
+CHeaderFile::CHeaderFile(const std::string &path) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if ( ! file) {
+        ThrowFileError(path, "cannot open");
+    }
+    nBytes = size_t(file.tellg());
+    if (nBytes % CBlockHeaderView::SIZE != 0) {
+        ThrowFileError(path, "size is not a multiple of the header size");
+    }
+    uint8_t *buffer = new uint8_t[nBytes];
+    file.seekg(0);
+    if ( ! file.read(reinterpret_cast<char *>(buffer), std::streamsize(nBytes))) {
+        delete[] buffer;
+        ThrowFileError(path, "cannot read");
+    }
+    pData = buffer;
+}
+
+CHeaderFile::~CHeaderFile() {
+    delete[] pData;
+}
+
+#else
+
+CHeaderFile::CHeaderFile(const std::string &path) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        ThrowFileError(path, std::strerror(errno));
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        const int nError = errno;
+        close(fd);
+        ThrowFileError(path, std::strerror(nError));
+    }
+    nBytes = size_t(st.st_size);
+    if (nBytes % CBlockHeaderView::SIZE != 0) {
+        close(fd);
+        ThrowFileError(path, "size is not a multiple of the header size");
+    }
+    if (nBytes > 0) {
+        void *p = mmap(nullptr, nBytes, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            const int nError = errno;
+            close(fd);
+            ThrowFileError(path, std::strerror(nError));
+        }
+        // Headers are read once, front to back.
+        madvise(p, nBytes, MADV_SEQUENTIAL);
+        pData = static_cast<const uint8_t *>(p);
+    }
+    // The mapping stays valid after the descriptor is closed.
+    close(fd);
+}
+
+CHeaderFile::~CHeaderFile() {
+    if (pData != nullptr) {
+        munmap(const_cast<uint8_t *>(pData), nBytes);
+    }
+}
+
+#endif
+
+void AppendHeaders(CChainStore &chain, const uint8_t *data, size_t count, unsigned int nThreads) {
+    // Decoded in chunks, so the chain work of a whole chunk is computed at once.
+    constexpr size_t chunkSize = 65536;
+    std::vector<uint32_t> times(std::min(count, chunkSize));
+    std::vector<uint32_t> bits(times.size());
+    for (size_t begin = 0; begin < count; begin += chunkSize) {
+        const size_t n = std::min(chunkSize, count - begin);
+        for (size_t i = 0; i < n; ++i) {
+            const CBlockHeaderView header(data + (begin + i) * CBlockHeaderView::SIZE);
+            times[i] = header.GetTime();
+            bits[i] = header.GetBits();
+        }
+        chain.append(times.data(), bits.data(), n, nThreads);
+    }
+}
+
+void AppendHeaders(CChainStore &chain, const CHeaderFile &file, unsigned int nThreads) {
+    chain.reserve(chain.size() + file.size());
+    AppendHeaders(chain, file.data(), file.size(), nThreads);
+}
@@ -0,0 +1,49 @@
+#ifndef ASERTI3_416_HEADERS_HPP_
+#define ASERTI3_416_HEADERS_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "aserti3-416.hpp"
+
+/**
+ * Read-only memory mapping of a raw header dump: serialized block headers,
+ * CBlockHeaderView::SIZE bytes each, back to back in height order. Headers
+ * are read in place through CBlockHeaderView. Throws std::runtime_error if
+ * the file cannot be mapped or its size is not a whole number of headers.
+ */
+class CHeaderFile {
+public:
+    explicit CHeaderFile(const std::string &path);
+    ~CHeaderFile();
+
+    CHeaderFile(const CHeaderFile &) = delete;
+    CHeaderFile &operator=(const CHeaderFile &) = delete;
+
+    size_t size() const { return nBytes / CBlockHeaderView::SIZE; }
+    bool empty() const { return nBytes == 0; }
+    CBlockHeaderView operator[](size_t i) const {
+        return CBlockHeaderView(pData + i * CBlockHeaderView::SIZE);
+    }
+
+    /** The serialized headers. */
+    const uint8_t *data() const { return pData; }
+
+private:
+    const uint8_t *pData = nullptr;
+    size_t nBytes = 0;
+};
+
+/**
+ * Appends count serialized headers starting at data to chain, the first one
+ * at chain.TipHeight() + 1. Only time and bits are read from the buffer.
+ * The chain work, if the chain keeps it, is computed on nThreads threads
+ * (0: one per hardware thread).
+ */
+void AppendHeaders(CChainStore &chain, const uint8_t *data, size_t count, unsigned int nThreads = 1);
+
+/** Appends every header of file to chain. */
+void AppendHeaders(CChainStore &chain, const CHeaderFile &file, unsigned int nThreads = 1);
+
+#endif // ASERTI3_416_HEADERS_HPP_
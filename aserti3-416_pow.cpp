@@ -0,0 +1,506 @@
+/**
+ * Copyright (c) 2020 Fernando Pelliccioni
+ */
+
+// Batch proof-of-work check of serialized headers.
+//
+// A header is 80 bytes, so its double SHA-256 is three compressions: the
+// first 64 bytes, the last 16 plus padding, and the 32-byte first hash plus
+// padding. Most of the last two message blocks is constant.
+//
+// Kernels, selected at load time depending on the running CPU:
+//   shani:  SHA extensions, two headers interleaved to hide the latency of
+//           sha256rnds2.
+//   avx2:   eight headers per call, one per 32-bit lane.
+//   scalar: portable fallback.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+#include "aserti3-416_pow.hpp"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define ASERT_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+constexpr size_t headerSize = CBlockHeaderView::SIZE;
+
+const uint32_t K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+const uint32_t initialState[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+};
+
+// Second block of a header: bytes 64..79, then the padding of a 640-bit message.
+constexpr uint32_t headerPad[12] = {0x80000000, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 640};
+
+// Second compression of the double hash: the first hash, then the padding of a
+// 256-bit message.
+constexpr uint32_t hashPad[8] = {0x80000000, 0, 0, 0, 0, 0, 0, 256};
+
+inline uint32_t ReadBE32(const uint8_t *ptr) {
+    uint32_t x;
+    memcpy((char *)&x, ptr, 4);
+    return be32toh(x);
+}
+
+inline void WriteBE32(uint8_t *ptr, uint32_t x) {
+    uint32_t v = htobe32(x);
+    memcpy(ptr, (char *)&v, 4);
+}
+
+// Scalar -----------------------------------------------------------------------
+
+inline uint32_t Rotr(uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+
+// One compression of the already decoded message words w.
+void Transform(uint32_t *s, const uint32_t *w) {
+    uint32_t W[64];
+    memcpy(W, w, sizeof(uint32_t) * 16);
+    for (int i = 16; i < 64; ++i) {
+        const uint32_t s0 = Rotr(W[i - 15], 7) ^ Rotr(W[i - 15], 18) ^ (W[i - 15] >> 3);
+        const uint32_t s1 = Rotr(W[i - 2], 17) ^ Rotr(W[i - 2], 19) ^ (W[i - 2] >> 10);
+        W[i] = W[i - 16] + s0 + W[i - 7] + s1;
+    }
+
+    uint32_t a = s[0], b = s[1], c = s[2], d = s[3], e = s[4], f = s[5], g = s[6], h = s[7];
+    for (int i = 0; i < 64; ++i) {
+        const uint32_t t1 = h + (Rotr(e, 6) ^ Rotr(e, 11) ^ Rotr(e, 25)) + (g ^ (e & (f ^ g))) + K[i] + W[i];
+        const uint32_t t2 = (Rotr(a, 2) ^ Rotr(a, 13) ^ Rotr(a, 22)) + ((a & b) | (c & (a | b)));
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+    s[0] += a;
+    s[1] += b;
+    s[2] += c;
+    s[3] += d;
+    s[4] += e;
+    s[5] += f;
+    s[6] += g;
+    s[7] += h;
+}
+
+void SHA256dScalar(const uint8_t *headers, size_t count, uint8_t *hashesOut) noexcept {
+    for (size_t i = 0; i < count; ++i) {
+        const uint8_t *header = headers + i * headerSize;
+        uint32_t w[16];
+        uint32_t s[8];
+        memcpy(s, initialState, sizeof(s));
+
+        for (int j = 0; j < 16; ++j) {
+            w[j] = ReadBE32(header + 4 * j);
+        }
+        Transform(s, w);
+        for (int j = 0; j < 4; ++j) {
+            w[j] = ReadBE32(header + 64 + 4 * j);
+        }
+        memcpy(w + 4, headerPad, sizeof(headerPad));
+        Transform(s, w);
+
+        memcpy(w, s, sizeof(s));
+        memcpy(w + 8, hashPad, sizeof(hashPad));
+        memcpy(s, initialState, sizeof(s));
+        Transform(s, w);
+
+        for (int j = 0; j < 8; ++j) {
+            WriteBE32(hashesOut + i * 32 + 4 * j, s[j]);
+        }
+    }
+}
+
+#if defined(ASERT_X86_SIMD)
+
+// AVX2 -------------------------------------------------------------------------
+
+__attribute__((target("avx2")))
+inline __m256i Rotr8x(__m256i x, int n) {
+    return _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - n));
+}
+
+// One compression of eight independent states, one per lane. w holds the 16
+// message words of every lane and is used as the schedule's ring buffer.
+__attribute__((target("avx2")))
+inline void Transform8x(__m256i *s, __m256i *w) {
+    __m256i a = s[0], b = s[1], c = s[2], d = s[3], e = s[4], f = s[5], g = s[6], h = s[7];
+    for (int i = 0; i < 64; ++i) {
+        if (i >= 16) {
+            const __m256i w15 = w[(i - 15) & 15];
+            const __m256i w2 = w[(i - 2) & 15];
+            const __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(Rotr8x(w15, 7), Rotr8x(w15, 18)),
+                                                _mm256_srli_epi32(w15, 3));
+            const __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(Rotr8x(w2, 17), Rotr8x(w2, 19)),
+                                                _mm256_srli_epi32(w2, 10));
+            w[i & 15] = _mm256_add_epi32(_mm256_add_epi32(w[i & 15], s0),
+                                         _mm256_add_epi32(w[(i - 7) & 15], s1));
+        }
+        const __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(Rotr8x(e, 6), Rotr8x(e, 11)), Rotr8x(e, 25));
+        const __m256i ch = _mm256_xor_si256(g, _mm256_and_si256(e, _mm256_xor_si256(f, g)));
+        const __m256i t1 = _mm256_add_epi32(_mm256_add_epi32(_mm256_add_epi32(h, s1), ch),
+                                            _mm256_add_epi32(_mm256_set1_epi32(int(K[i])), w[i & 15]));
+        const __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(Rotr8x(a, 2), Rotr8x(a, 13)), Rotr8x(a, 22));
+        const __m256i maj = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(c, _mm256_or_si256(a, b)));
+        h = g;
+        g = f;
+        f = e;
+        e = _mm256_add_epi32(d, t1);
+        d = c;
+        c = b;
+        b = a;
+        a = _mm256_add_epi32(t1, _mm256_add_epi32(s0, maj));
+    }
+    s[0] = _mm256_add_epi32(s[0], a);
+    s[1] = _mm256_add_epi32(s[1], b);
+    s[2] = _mm256_add_epi32(s[2], c);
+    s[3] = _mm256_add_epi32(s[3], d);
+    s[4] = _mm256_add_epi32(s[4], e);
+    s[5] = _mm256_add_epi32(s[5], f);
+    s[6] = _mm256_add_epi32(s[6], g);
+    s[7] = _mm256_add_epi32(s[7], h);
+}
+
+__attribute__((target("avx2")))
+void SHA256dAVX2(const uint8_t *headers, size_t count, uint8_t *hashesOut) noexcept {
+    // Message word j of the eight headers, gathered with a header-size stride
+    // and turned big endian.
+    const __m256i stride = _mm256_setr_epi32(0, 80, 160, 240, 320, 400, 480, 560);
+    const __m256i bswap = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                           3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    static_assert(headerSize == 80, "gather stride");
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const uint8_t *base = headers + i * headerSize;
+        __m256i s[8];
+        __m256i w[16];
+        for (int j = 0; j < 8; ++j) {
+            s[j] = _mm256_set1_epi32(int(initialState[j]));
+        }
+
+        for (int j = 0; j < 16; ++j) {
+            w[j] = _mm256_shuffle_epi8(_mm256_i32gather_epi32((const int *)(base + 4 * j), stride, 1), bswap);
+        }
+        Transform8x(s, w);
+        for (int j = 0; j < 4; ++j) {
+            w[j] = _mm256_shuffle_epi8(_mm256_i32gather_epi32((const int *)(base + 64 + 4 * j), stride, 1), bswap);
+        }
+        for (int j = 0; j < 12; ++j) {
+            w[4 + j] = _mm256_set1_epi32(int(headerPad[j]));
+        }
+        Transform8x(s, w);
+
+        // The first hash never leaves the lanes.
+        for (int j = 0; j < 8; ++j) {
+            w[j] = s[j];
+            w[8 + j] = _mm256_set1_epi32(int(hashPad[j]));
+            s[j] = _mm256_set1_epi32(int(initialState[j]));
+        }
+        Transform8x(s, w);
+
+        alignas(32) uint32_t words[8][8];
+        for (int j = 0; j < 8; ++j) {
+            _mm256_store_si256((__m256i *)words[j], _mm256_shuffle_epi8(s[j], bswap));
+        }
+        for (int lane = 0; lane < 8; ++lane) {
+            uint8_t *out = hashesOut + (i + lane) * 32;
+            for (int j = 0; j < 8; ++j) {
+                memcpy(out + 4 * j, &words[j][lane], 4);
+            }
+        }
+    }
+    SHA256dScalar(headers + i * headerSize, count - i, hashesOut + i * 32);
+}
+
+// SHA extensions ---------------------------------------------------------------
+
+// State in the ABEF/CDGH layout sha256rnds2 works on, for two interleaved
+// messages.
+struct ShaState2x {
+    __m128i abef[2];
+    __m128i cdgh[2];
+};
+
+__attribute__((target("sha,sse4.1")))
+inline void LoadState2x(ShaState2x &st, const uint32_t *s0, const uint32_t *s1) {
+    const uint32_t *s[2] = {s0, s1};
+    for (int k = 0; k < 2; ++k) {
+        const __m128i dcba = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)s[k]), 0xB1);  // CDAB
+        const __m128i hgfe = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)(s[k] + 4)), 0x1B);  // EFGH
+        st.abef[k] = _mm_alignr_epi8(dcba, hgfe, 8);
+        st.cdgh[k] = _mm_blend_epi16(hgfe, dcba, 0xF0);
+    }
+}
+
+__attribute__((target("sha,sse4.1")))
+inline void StoreState(const __m128i &abef, const __m128i &cdgh, uint32_t *s) {
+    const __m128i feba = _mm_shuffle_epi32(abef, 0x1B);
+    const __m128i dchg = _mm_shuffle_epi32(cdgh, 0xB1);
+    _mm_storeu_si128((__m128i *)s, _mm_blend_epi16(feba, dchg, 0xF0));
+    _mm_storeu_si128((__m128i *)(s + 4), _mm_alignr_epi8(dchg, feba, 8));
+}
+
+// One compression of two messages, m holding the 16 big endian words of each
+// (already decoded, four per register) and used as the schedule's ring buffer.
+__attribute__((target("sha,sse4.1")))
+inline void TransformSha2x(ShaState2x &st, __m128i (*m)[4]) {
+    const __m128i abef[2] = {st.abef[0], st.abef[1]};
+    const __m128i cdgh[2] = {st.cdgh[0], st.cdgh[1]};
+    for (int r = 0; r < 16; ++r) {
+        const __m128i k = _mm_loadu_si128((const __m128i *)&K[4 * r]);
+        for (int j = 0; j < 2; ++j) {
+            const __m128i cur = m[j][r & 3];
+            __m128i msg = _mm_add_epi32(cur, k);
+            st.cdgh[j] = _mm_sha256rnds2_epu32(st.cdgh[j], st.abef[j], msg);
+            if (r >= 3 && r <= 14) {
+                __m128i &next = m[j][(r + 1) & 3];
+                next = _mm_add_epi32(next, _mm_alignr_epi8(cur, m[j][(r + 3) & 3], 4));
+                next = _mm_sha256msg2_epu32(next, cur);
+            }
+            msg = _mm_shuffle_epi32(msg, 0x0E);
+            st.abef[j] = _mm_sha256rnds2_epu32(st.abef[j], st.cdgh[j], msg);
+            if (r >= 1 && r <= 12) {
+                m[j][(r + 3) & 3] = _mm_sha256msg1_epu32(m[j][(r + 3) & 3], cur);
+            }
+        }
+    }
+    for (int j = 0; j < 2; ++j) {
+        st.abef[j] = _mm_add_epi32(st.abef[j], abef[j]);
+        st.cdgh[j] = _mm_add_epi32(st.cdgh[j], cdgh[j]);
+    }
+}
+
+__attribute__((target("sha,sse4.1")))
+inline __m128i LoadBE128(const uint8_t *ptr) {
+    const __m128i bswap = _mm_set_epi64x(0x0c0d0e0f08090a0bll, 0x0405060700010203ll);
+    return _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)ptr), bswap);
+}
+
+__attribute__((target("sha,sse4.1")))
+void SHA256dShaNi(const uint8_t *headers, size_t count, uint8_t *hashesOut) noexcept {
+    const __m128i pad1 = _mm_loadu_si128((const __m128i *)headerPad);
+    const __m128i pad2 = _mm_loadu_si128((const __m128i *)(headerPad + 4));
+    const __m128i pad3 = _mm_loadu_si128((const __m128i *)(headerPad + 8));
+    const __m128i hpad0 = _mm_loadu_si128((const __m128i *)hashPad);
+    const __m128i hpad1 = _mm_loadu_si128((const __m128i *)(hashPad + 4));
+
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        const uint8_t *h[2] = {headers + i * headerSize, headers + (i + 1) * headerSize};
+        ShaState2x st;
+        __m128i m[2][4];
+
+        LoadState2x(st, initialState, initialState);
+        for (int j = 0; j < 2; ++j) {
+            for (int q = 0; q < 4; ++q) {
+                m[j][q] = LoadBE128(h[j] + 16 * q);
+            }
+        }
+        TransformSha2x(st, m);
+        for (int j = 0; j < 2; ++j) {
+            m[j][0] = LoadBE128(h[j] + 64);
+            m[j][1] = pad1;
+            m[j][2] = pad2;
+            m[j][3] = pad3;
+        }
+        TransformSha2x(st, m);
+
+        uint32_t first[2][8];
+        for (int j = 0; j < 2; ++j) {
+            StoreState(st.abef[j], st.cdgh[j], first[j]);
+            m[j][0] = _mm_loadu_si128((const __m128i *)first[j]);
+            m[j][1] = _mm_loadu_si128((const __m128i *)(first[j] + 4));
+            m[j][2] = hpad0;
+            m[j][3] = hpad1;
+        }
+        LoadState2x(st, initialState, initialState);
+        TransformSha2x(st, m);
+
+        for (int j = 0; j < 2; ++j) {
+            uint32_t s[8];
+            StoreState(st.abef[j], st.cdgh[j], s);
+            for (int q = 0; q < 8; ++q) {
+                WriteBE32(hashesOut + (i + j) * 32 + 4 * q, s[q]);
+            }
+        }
+    }
+    SHA256dScalar(headers + i * headerSize, count - i, hashesOut + i * 32);
+}
+
+#endif // defined(ASERT_X86_SIMD)
+
+using SHA256dFn = void (*)(const uint8_t *, size_t, uint8_t *) noexcept;
+
+struct Kernel {
+    SHA256dFn fn;
+    const char *name;
+};
+
+// The kernels of this build the running CPU supports, best first.
+std::vector<Kernel> SupportedKernels() {
+    std::vector<Kernel> kernels;
+#if defined(ASERT_X86_SIMD)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sha") && __builtin_cpu_supports("sse4.1")) {
+        kernels.push_back({SHA256dShaNi, "shani"});
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        kernels.push_back({SHA256dAVX2, "avx2"});
+    }
+#endif
+    kernels.push_back({SHA256dScalar, "scalar"});
+    return kernels;
+}
+
+// Resolved once at load time, no per-call dispatch cost.
+const Kernel kernel = SupportedKernels().front();
+
+// Target of a compact nBits as four little endian 64-bit words, with the
+// validity rules of CheckProofOfWork. The 23-bit mantissa spans at most two
+// words.
+bool DecodeTarget(uint32_t nBits, uint64_t *target) {
+    const int nSize = nBits >> 24;
+    uint64_t nWord = nBits & 0x007fffff;
+    target[0] = target[1] = target[2] = target[3] = 0;
+    if (nWord == 0) {
+        return false;
+    }
+    if ((nBits & 0x00800000) != 0) {
+        return false;
+    }
+    if (nSize > 34 || (nWord > 0xff && nSize > 33) || (nWord > 0xffff && nSize > 32)) {
+        return false;
+    }
+    if (nSize <= 3) {
+        nWord >>= 8 * (3 - nSize);
+        if (nWord == 0) {
+            return false;
+        }
+        target[0] = nWord;
+        return true;
+    }
+    // Bit position of the mantissa, below 256 - 8 since the word fits.
+    const int shift = 8 * (nSize - 3);
+    const int limb = shift / 64;
+    const int bits = shift % 64;
+    target[limb] = nWord << bits;
+    if (bits > 64 - 24 && limb < 3) {
+        target[limb + 1] = nWord >> (64 - bits);
+    }
+    return true;
+}
+
+// a <= b, both four little endian 64-bit words.
+inline bool LessOrEqual(const uint64_t *a, const uint64_t *b) {
+    for (int i = 3; i >= 0; --i) {
+        if (a[i] != b[i]) {
+            return a[i] < b[i];
+        }
+    }
+    return true;
+}
+
+inline void LoadWords(const uint8_t *ptr, uint64_t *words) {
+    for (int i = 0; i < 4; ++i) {
+        words[i] = ReadLE64(ptr + 8 * i);
+    }
+}
+
+// Checks nBits' target, for a hash as four little endian 64-bit words.
+class CTargetChecker {
+public:
+    explicit CTargetChecker(const Consensus::Params &params) {
+        LoadWords(params.powLimit.begin(), powLimit);
+    }
+
+    bool Check(const uint64_t *hash, uint32_t nBits) {
+        // Consecutive headers mostly share nBits (or are a few apart), so the
+        // last decoded target is kept.
+        if (nBits != nLastBits || !fHaveLast) {
+            fLastValid = DecodeTarget(nBits, target) && LessOrEqual(target, powLimit);
+            nLastBits = nBits;
+            fHaveLast = true;
+        }
+        return fLastValid && LessOrEqual(hash, target);
+    }
+
+private:
+    uint64_t powLimit[4];
+    uint64_t target[4];
+    uint32_t nLastBits = 0;
+    bool fLastValid = false;
+    bool fHaveLast = false;
+};
+
+} // namespace
+
+void SHA256dHeaders(const uint8_t *headers, size_t count, uint8_t *hashesOut) noexcept {
+    kernel.fn(headers, count, hashesOut);
+}
+
+const char *SHA256dKernelName() noexcept {
+    return kernel.name;
+}
+
+bool SHA256dHeadersOn(const char *kernelName, const uint8_t *headers, size_t count, uint8_t *hashesOut) {
+    for (const Kernel &k : SupportedKernels()) {
+        if (std::strcmp(k.name, kernelName) == 0) {
+            k.fn(headers, count, hashesOut);
+            return true;
+        }
+    }
+    return false;
+}
+
+BlockHash GetBlockHash(const CBlockHeaderView &header) noexcept {
+    BlockHash hash;
+    SHA256dHeaders(header.data(), 1, hash.begin());
+    return hash;
+}
+
+bool CheckProofOfWork(const BlockHash &hash, uint32_t nBits, const Consensus::Params &params) noexcept {
+    uint64_t words[4];
+    LoadWords(hash.begin(), words);
+    return CTargetChecker(params).Check(words, nBits);
+}
+
+size_t FindFirstInvalidProofOfWork(const uint8_t *headers, size_t count, const Consensus::Params &params) noexcept {
+    // Hashed in chunks that stay in L1, so a failure early in a large batch
+    // does not pay for the whole batch.
+    constexpr size_t chunk = 256;
+    uint8_t hashes[chunk * 32];
+    CTargetChecker checker(params);
+
+    for (size_t begin = 0; begin < count; begin += chunk) {
+        const size_t n = std::min(chunk, count - begin);
+        SHA256dHeaders(headers + begin * headerSize, n, hashes);
+        for (size_t i = 0; i < n; ++i) {
+            const CBlockHeaderView header(headers + (begin + i) * headerSize);
+            uint64_t words[4];
+            LoadWords(hashes + i * 32, words);
+            if (!checker.Check(words, header.GetBits())) {
+                return begin + i;
+            }
+        }
+    }
+    return count;
+}
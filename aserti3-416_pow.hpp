@@ -0,0 +1,43 @@
+#ifndef ASERTI3_416_POW_HPP_
+#define ASERTI3_416_POW_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "aserti3-416.hpp"
+
+/**
+ * Double SHA-256 of count serialized headers (CBlockHeaderView::SIZE bytes
+ * each, back to back), 32 bytes per hash to hashesOut, in uint256 byte
+ * order: the block hash of header i is hashesOut + 32 * i.
+ */
+void SHA256dHeaders(const uint8_t *headers, size_t count, uint8_t *hashesOut) noexcept;
+
+/** Kernel SHA256dHeaders() runs on this CPU: "shani", "avx2" or "scalar". */
+const char *SHA256dKernelName() noexcept;
+
+/**
+ * SHA256dHeaders on the named kernel instead of the selected one, for tests
+ * comparing them. Returns false, hashing nothing, if this build has no such
+ * kernel or the CPU cannot run it.
+ */
+bool SHA256dHeadersOn(const char *kernelName, const uint8_t *headers, size_t count, uint8_t *hashesOut);
+
+/** The block hash of a header. */
+BlockHash GetBlockHash(const CBlockHeaderView &header) noexcept;
+
+/**
+ * BCHN's CheckProofOfWork: nBits decodes to a positive target no higher than
+ * powLimit and the hash, as a little endian number, does not exceed it.
+ */
+bool CheckProofOfWork(const BlockHash &hash, uint32_t nBits, const Consensus::Params &params) noexcept;
+
+/**
+ * Hashes count serialized headers in batches and checks each against its
+ * own nBits, as CheckProofOfWork does. Targets are compared word by word
+ * from the compact form, with no arith_uint256 per header.
+ * Returns the index of the first header that fails, count if none does.
+ */
+size_t FindFirstInvalidProofOfWork(const uint8_t *headers, size_t count, const Consensus::Params &params) noexcept;
+
+#endif // ASERTI3_416_POW_HPP_
@@ -1,4 +1,5 @@
 #include <Python.h>
+#include <string.h>
 #include "aserti3-416_pyapi.h"
 #include "aserti3-416_capi.h"
 
@@ -23,7 +24,72 @@ PyObject* to_py_obj(void* obj) {
 #endif /* PY_MAJOR_VERSION >= 3 */
 }
 
+// Buffers ------------------------------------------------------------------
+// Bulk inputs and outputs are any object exporting the buffer protocol
+// (NumPy arrays, array.array, memoryview, bytes): read and written in place,
+// with no per-element Python objects.
 
+// Integer item formats of the struct module, native byte order.
+static int is_int_format(char const* format) {
+    if (format == NULL) {
+        return 1;   // unsigned bytes
+    }
+#if PY_LITTLE_ENDIAN
+    if (*format == '@' || *format == '=' || *format == '<') {
+#else
+    if (*format == '@' || *format == '=' || *format == '>' || *format == '!') {
+#endif
+        ++format;
+    }
+    return format[0] != '\0' && format[1] == '\0' && strchr("bBhHiIlLqQnN", format[0]) != NULL;
+}
+
+// C-contiguous buffer of itemsize byte integers, writable if fWritable. Items
+// are read and written as the fixed width type of the C API whatever their
+// signedness. Sets a TypeError naming the argument and returns 0 otherwise.
+static int get_int_buffer(PyObject* obj, Py_buffer* view, Py_ssize_t itemsize, int fWritable, char const* name) {
+    int flags = PyBUF_C_CONTIGUOUS | PyBUF_FORMAT | (fWritable ? PyBUF_WRITABLE : 0);
+    if (PyObject_GetBuffer(obj, view, flags) != 0) {
+        return 0;
+    }
+    if (view->itemsize != itemsize || ! is_int_format(view->format)) {
+        PyErr_Format(PyExc_TypeError, "%s must be a buffer of %d byte integers", name, (int)itemsize);
+        PyBuffer_Release(view);
+        return 0;
+    }
+    return 1;
+}
+
+// C-contiguous buffer of serialized 80 byte headers, back to back. Sets the
+// Python error and returns 0 otherwise.
+static int get_headers_buffer(PyObject* obj, Py_buffer* view, char const* name) {
+    if (PyObject_GetBuffer(obj, view, PyBUF_C_CONTIGUOUS) != 0) {
+        return 0;
+    }
+    if (view->len % 80 != 0) {
+        PyErr_Format(PyExc_ValueError, "%s size is not a multiple of the header size", name);
+        PyBuffer_Release(view);
+        return 0;
+    }
+    return 1;
+}
+
+// List of count nBits. Returns NULL, with the Python error set, on failure.
+static PyObject* bits_to_list(uint32_t const* nBits, Py_ssize_t count) {
+    PyObject* res = PyList_New(count);
+    if (res == NULL) {
+        return NULL;
+    }
+    for (Py_ssize_t i = 0; i < count; ++i) {
+        PyObject* item = PyLong_FromUnsignedLong(nBits[i]);
+        if (item == NULL) {
+            Py_DECREF(res);
+            return NULL;
+        }
+        PyList_SET_ITEM(res, i, item);
+    }
+    return res;
+}
 
 
 // class CBlockIndex --------------------------------------------------------
@@ -112,6 +178,36 @@ PyObject* PyAPI_CBlockIndex_set_pprev(PyObject* self, PyObject* args) {
     Py_RETURN_NONE;
 }
 
+PyObject* PyAPI_CBlockIndex_link(PyObject* self, PyObject* args) {
+    PyObject* py_obj;
+    PyObject* py_pprev;
+
+    if ( ! PyArg_ParseTuple(args, "OO", &py_obj, &py_pprev)) {
+        return NULL;
+    }
+    void* obj = get_ptr(py_obj);
+    void* pprev = get_ptr(py_pprev);
+    CAPI_CBlockIndex_link(obj, pprev);
+
+    Py_RETURN_NONE;
+}
+
+// The returned block is owned by whoever created it, like the argument.
+PyObject* PyAPI_CBlockIndex_GetAncestor(PyObject* self, PyObject* args) {
+    PyObject* py_obj;
+    int height;
+
+    if ( ! PyArg_ParseTuple(args, "Oi", &py_obj, &height)) {
+        return NULL;
+    }
+    void* obj = get_ptr(py_obj);
+    void* res = CAPI_CBlockIndex_GetAncestor(obj, height);
+    if (res == NULL) {
+        Py_RETURN_NONE;
+    }
+    return to_py_obj(res);
+}
+
 
 
 PyObject* PyAPI_CBlockIndex_set_nChainWork(PyObject* self, PyObject* args) {
@@ -192,6 +288,58 @@ PyObject* PyAPI_Params_destruct(PyObject* self, PyObject* args) {
     Py_RETURN_NONE;
 }
 
+PyObject* PyAPI_Params_set_powLimit(PyObject* self, PyObject* args) {
+    PyObject* py_obj;
+    uint32_t nCompact;
+
+    if ( ! PyArg_ParseTuple(args, "OI", &py_obj, &nCompact)) {
+        return NULL;
+    }
+    void* obj = get_ptr(py_obj);
+    CAPI_Params_set_powLimit(obj, nCompact);
+
+    Py_RETURN_NONE;
+}
+
+PyObject* PyAPI_Params_set_nDAAHalfLife(PyObject* self, PyObject* args) {
+    PyObject* py_obj;
+    long long nDAAHalfLife;
+
+    if ( ! PyArg_ParseTuple(args, "OL", &py_obj, &nDAAHalfLife)) {
+        return NULL;
+    }
+    void* obj = get_ptr(py_obj);
+    CAPI_Params_set_nDAAHalfLife(obj, nDAAHalfLife);
+
+    Py_RETURN_NONE;
+}
+
+PyObject* PyAPI_Params_set_nPowTargetSpacing(PyObject* self, PyObject* args) {
+    PyObject* py_obj;
+    long long nPowTargetSpacing;
+
+    if ( ! PyArg_ParseTuple(args, "OL", &py_obj, &nPowTargetSpacing)) {
+        return NULL;
+    }
+    void* obj = get_ptr(py_obj);
+    CAPI_Params_set_nPowTargetSpacing(obj, nPowTargetSpacing);
+
+    Py_RETURN_NONE;
+}
+
+PyObject* PyAPI_Params_set_fPowAllowMinDifficultyBlocks(PyObject* self, PyObject* args) {
+    PyObject* py_obj;
+    int fPowAllowMinDifficultyBlocks;
+
+    if ( ! PyArg_ParseTuple(args, "Op", &py_obj, &fPowAllowMinDifficultyBlocks)) {
+        return NULL;
+    }
+    void* obj = get_ptr(py_obj);
+    CAPI_Params_set_fPowAllowMinDifficultyBlocks(obj, fPowAllowMinDifficultyBlocks);
+
+    Py_RETURN_NONE;
+}
+
 
 // GetNextASERTWorkRequired --------------------------------------------------------
 PyObject* PyAPI_GetNextASERTWorkRequired(PyObject* self, PyObject* args) {
@@ -210,10 +358,178 @@ PyObject* PyAPI_GetNextASERTWorkRequired(PyObject* self, PyObject* args) {
     void* params = get_ptr(py_params);
     void* pindexReferenceBlock = get_ptr(py_pindexReferenceBlock);
 
-    uint32_t res = CAPI_GetNextASERTWorkRequired(pindexPrev, pblock, params, pindexReferenceBlock, debugASERT);
+    // The C++ side touches no Python objects and keeps no shared mutable
+    // state, so other threads may run while it computes.
+    uint32_t res;
+    Py_BEGIN_ALLOW_THREADS
+    res = CAPI_GetNextASERTWorkRequired(pindexPrev, pblock, params, pindexReferenceBlock, debugASERT);
+    Py_END_ALLOW_THREADS
     return Py_BuildValue("I", res);   
 }
 
+// The returned block is owned by whoever created it, like the argument.
+PyObject* PyAPI_GetSuitableBlock(PyObject* self, PyObject* args) {
+    PyObject* py_obj;
+
+    if ( ! PyArg_ParseTuple(args, "O", &py_obj)) {
+        return NULL;
+    }
+    void* obj = get_ptr(py_obj);
+    return to_py_obj((void*)CAPI_GetSuitableBlock(obj));
+}
+
+PyObject* PyAPI_GetNextASERTMo3WorkRequired(PyObject* self, PyObject* args) {
+    PyObject* py_pindexPrev;
+    PyObject* py_pblock;
+    PyObject* py_params;
+    PyObject* py_pindexAnchor;
+    int debugASERT;
+
+    if ( ! PyArg_ParseTuple(args, "OOOOp", &py_pindexPrev, &py_pblock, &py_params, &py_pindexAnchor, &debugASERT)) {
+        return NULL;
+    }
+
+    void* pindexPrev = get_ptr(py_pindexPrev);
+    void* pblock = get_ptr(py_pblock);
+    void* params = get_ptr(py_params);
+    void* pindexAnchor = get_ptr(py_pindexAnchor);
+
+    uint32_t res;
+    Py_BEGIN_ALLOW_THREADS
+    res = CAPI_GetNextASERTMo3WorkRequired(pindexPrev, pblock, params, pindexAnchor, debugASERT);
+    Py_END_ALLOW_THREADS
+    return Py_BuildValue("I", res);
+}
+
+// CalculateASERTBatch(nRefBits, time_diffs, height_diffs, params) -> list of nBits
+PyObject* PyAPI_CalculateASERTBatch(PyObject* self, PyObject* args) {
+    uint32_t nRefBits;
+    PyObject* py_time_diffs;
+    PyObject* py_height_diffs;
+    PyObject* py_params;
+
+    if ( ! PyArg_ParseTuple(args, "IOOO", &nRefBits, &py_time_diffs, &py_height_diffs, &py_params)) {
+        return NULL;
+    }
+
+    void* params = get_ptr(py_params);
+
+    PyObject* time_diffs = PySequence_Fast(py_time_diffs, "time_diffs must be a sequence");
+    if (time_diffs == NULL) {
+        return NULL;
+    }
+    PyObject* height_diffs = PySequence_Fast(py_height_diffs, "height_diffs must be a sequence");
+    if (height_diffs == NULL) {
+        Py_DECREF(time_diffs);
+        return NULL;
+    }
+
+    PyObject* res = NULL;
+    Py_ssize_t count = PySequence_Fast_GET_SIZE(time_diffs);
+    int64_t* nTimeDiffs = NULL;
+    int64_t* nHeightDiffs = NULL;
+    uint32_t* nBitsOut = NULL;
+
+    if (PySequence_Fast_GET_SIZE(height_diffs) != count) {
+        PyErr_SetString(PyExc_ValueError, "time_diffs and height_diffs must have the same length");
+        goto cleanup;
+    }
+
+    nTimeDiffs = (int64_t*)PyMem_Malloc(sizeof(int64_t) * (count + 1));
+    nHeightDiffs = (int64_t*)PyMem_Malloc(sizeof(int64_t) * (count + 1));
+    nBitsOut = (uint32_t*)PyMem_Malloc(sizeof(uint32_t) * (count + 1));
+    if (nTimeDiffs == NULL || nHeightDiffs == NULL || nBitsOut == NULL) {
+        PyErr_NoMemory();
+        goto cleanup;
+    }
+
+    for (Py_ssize_t i = 0; i < count; ++i) {
+        nTimeDiffs[i] = PyLong_AsLongLong(PySequence_Fast_GET_ITEM(time_diffs, i));
+        if (nTimeDiffs[i] == -1 && PyErr_Occurred()) {
+            goto cleanup;
+        }
+        nHeightDiffs[i] = PyLong_AsLongLong(PySequence_Fast_GET_ITEM(height_diffs, i));
+        if (nHeightDiffs[i] == -1 && PyErr_Occurred()) {
+            goto cleanup;
+        }
+    }
+
+    // Inputs were copied into native buffers above, so the GIL can be released.
+    int ok;
+    Py_BEGIN_ALLOW_THREADS
+    ok = CAPI_CalculateASERTBatch(nRefBits, nTimeDiffs, nHeightDiffs, (size_t)count, params, nBitsOut);
+    Py_END_ALLOW_THREADS
+    if ( ! ok) {
+        PyErr_SetString(PyExc_ValueError, "nRefBits must be a target in (0, powLimit] and height_diffs must not be negative");
+        goto cleanup;
+    }
+
+    res = bits_to_list(nBitsOut, count);
+
+cleanup:
+    PyMem_Free(nTimeDiffs);
+    PyMem_Free(nHeightDiffs);
+    PyMem_Free(nBitsOut);
+    Py_DECREF(time_diffs);
+    Py_DECREF(height_diffs);
+    return res;
+}
+
+// CalculateASERTBatch_into(nRefBits, time_diffs, height_diffs, params, out)
+// Buffers of 8 byte integers in, nBits to a writable buffer of 4 byte integers
+// of the same length.
+PyObject* PyAPI_CalculateASERTBatch_into(PyObject* self, PyObject* args) {
+    uint32_t nRefBits;
+    PyObject* py_time_diffs;
+    PyObject* py_height_diffs;
+    PyObject* py_params;
+    PyObject* py_out;
+
+    if ( ! PyArg_ParseTuple(args, "IOOOO", &nRefBits, &py_time_diffs, &py_height_diffs, &py_params, &py_out)) {
+        return NULL;
+    }
+    void* params = get_ptr(py_params);
+
+    Py_buffer time_diffs;
+    Py_buffer height_diffs;
+    Py_buffer out;
+    if ( ! get_int_buffer(py_time_diffs, &time_diffs, 8, 0, "time_diffs")) {
+        return NULL;
+    }
+    if ( ! get_int_buffer(py_height_diffs, &height_diffs, 8, 0, "height_diffs")) {
+        PyBuffer_Release(&time_diffs);
+        return NULL;
+    }
+    if ( ! get_int_buffer(py_out, &out, 4, 1, "out")) {
+        PyBuffer_Release(&time_diffs);
+        PyBuffer_Release(&height_diffs);
+        return NULL;
+    }
+
+    PyObject* res = NULL;
+    size_t count = (size_t)(time_diffs.len / 8);
+    if (height_diffs.len / 8 != (Py_ssize_t)count || out.len / 4 != (Py_ssize_t)count) {
+        PyErr_SetString(PyExc_ValueError, "time_diffs, height_diffs and out must have the same length");
+    } else {
+        int ok;
+        Py_BEGIN_ALLOW_THREADS
+        ok = CAPI_CalculateASERTBatch(nRefBits, (int64_t const*)time_diffs.buf, (int64_t const*)height_diffs.buf,
+                                      count, params, (uint32_t*)out.buf);
+        Py_END_ALLOW_THREADS
+        if (ok) {
+            res = Py_None;
+            Py_INCREF(res);
+        } else {
+            PyErr_SetString(PyExc_ValueError, "nRefBits must be a target in (0, powLimit] and height_diffs must not be negative");
+        }
+    }
+
+    PyBuffer_Release(&time_diffs);
+    PyBuffer_Release(&height_diffs);
+    PyBuffer_Release(&out);
+    return res;
+}
+
 
 // PyObject* PyAPI_GetNextASERTWorkRequired(PyObject* self, PyObject* args) {
 //     PyObject* py_pindexPrev;
@@ -233,6 +549,882 @@ PyObject* PyAPI_GetNextASERTWorkRequired(PyObject* self, PyObject* args) {
 //     return Py_BuildValue("I", res);   
 // }
 
+
+// class ASERTChain --------------------------------------------------------
+PyObject* PyAPI_ASERTChain_construct(PyObject* self, PyObject* args) {
+    PyObject* py_params;
+
+    if ( ! PyArg_ParseTuple(args, "O", &py_params)) {
+        return NULL;
+    }
+    void* params = get_ptr(py_params);
+    void* res = CAPI_ASERTChain_construct(params);
+    return to_py_obj(res);
+}
+
+PyObject* PyAPI_ASERTChain_destruct(PyObject* self, PyObject* args) {
+    PyObject* py_obj;
+
+    if ( ! PyArg_ParseTuple(args, "O", &py_obj)) {
+        return NULL;
+    }
+    void* obj = get_ptr(py_obj);
+    CAPI_ASERTChain_destruct(obj);
+
+    Py_RETURN_NONE;
+}
+
+PyObject* PyAPI_ASERTChain_append(PyObject* self, PyObject* args) {
+    PyObject* py_obj;
+    int nHeight;
+    uint32_t nTime;
+    uint32_t nBits;
+
+    if ( ! PyArg_ParseTuple(args, "OiII", &py_obj, &nHeight, &nTime, &nBits)) {
+        return NULL;
+    }
+    void* obj = get_ptr(py_obj);
+    CAPI_ASERTChain_append(obj, nHeight, nTime, nBits);
+
+    Py_RETURN_NONE;
+}
+
+PyObject* PyAPI_ASERTChain_next_work_required(PyObject* self, PyObject* args) {
+    PyObject* py_obj;
+
+    if ( ! PyArg_ParseTuple(args, "O", &py_obj)) {
+        return NULL;
+    }
+    void* obj = get_ptr(py_obj);
+
+    uint32_t res;
+    Py_BEGIN_ALLOW_THREADS
+    res = CAPI_ASERTChain_next_work_required(obj);
+    Py_END_ALLOW_THREADS
+    if (res == 0) {
+        PyErr_SetString(PyExc_ValueError, "no block has been appended to the chain");
+        return NULL;
+    }
+    return Py_BuildValue("I", res);
+}
+
+// class CChainStore --------------------------------------------------------
+// Threads may share a chain store: readers hold its lock shared, mutators
+// exclusively, and heights are checked under the same hold as the work they
+// guard. The lock is waited for with the GIL released and no Python object is
+// touched while it is held, so neither lock waits on the other.
+
+// The C++ side asserts on heights outside the store; check them here instead,
+// with the lock held.
+static int chain_store_heights_valid(void const* obj, int nRefHeight, int nFirstPrevHeight, int nLastPrevHeight) {
+    return nRefHeight >= CAPI_ChainStore_get_first_height(obj)
+        && nFirstPrevHeight >= nRefHeight
+        && nLastPrevHeight <= CAPI_ChainStore_get_tip_height(obj);
+}
+
+// Whether count blocks from nFirstPrevHeight up are in the chain store, with
+// its lock held. In 64 bits: count is anything up to PY_SSIZE_T_MAX and
+// nFirstPrevHeight + count - 1 would overflow an int.
+static int chain_store_range_valid(void const* obj, int nFirstPrevHeight, Py_ssize_t count) {
+    int64_t const nTipHeight = CAPI_ChainStore_get_tip_height(obj);
+    return count == 0
+        || (nFirstPrevHeight <= nTipHeight && (int64_t)count <= nTipHeight - nFirstPrevHeight + 1);
+}
+
+static PyObject* chain_store_heights_error(void) {
+    PyErr_SetString(PyExc_IndexError, "heights out of the chain store or below the reference block");
+    return NULL;
+}
+
+PyObject* PyAPI_ChainStore_construct(PyObject* self, PyObject* args) {
+    int nFirstHeight;
+    int fChainWork = 0;
+
+    if ( ! PyArg_ParseTuple(args, "i|p", &nFirstHeight, &fChainWork)) {
+        return NULL;
+    }
+    void* res = CAPI_ChainStore_construct(nFirstHeight, fChainWork);
+    return to_py_obj(res);
+}
+
+PyObject* PyAPI_ChainStore_destruct(PyObject* self, PyObject* args) {
+    PyObject* py_obj;
+
+    if ( ! PyArg_ParseTuple(args, "O", &py_obj)) {
+        return NULL;
+    }
+    void* obj = get_ptr(py_obj);
+    CAPI_ChainStore_destruct(obj);
+
+    Py_RETURN_NONE;
+}
+
+PyObject* PyAPI_ChainStore_push_back(PyObject* self, PyObject* args) {
+    PyObject* py_obj;
+    uint32_t nTime;
+    uint32_t nBits;
+
+    if ( ! PyArg_ParseTuple(args, "OII", &py_obj, &nTime, &nBits)) {
+        return NULL;
+    }
+    void* obj = get_ptr(py_obj);
+    Py_BEGIN_ALLOW_THREADS
+    CAPI_ChainStore_lock(obj);
+    CAPI_ChainStore_push_back(obj, nTime, nBits);
+    CAPI_ChainStore_unlock(obj);
+    Py_END_ALLOW_THREADS
+
+    Py_RETURN_NONE;
+}
+
+// ChainStore_append(chain, times, bits[, threads])
+// Appends the blocks of two buffers of 4 byte integers of the same length. The
+// chain work, if kept, is computed on threads threads (0: one per hardware thread).
+PyObject* PyAPI_ChainStore_append(PyObject* self, PyObject* args) {
+    PyObject* py_obj;
+    PyObject* py_times;
+    PyObject* py_bits;
+    unsigned int nThreads = 1;
+
+    if ( ! PyArg_ParseTuple(args, "OOO|I", &py_obj, &py_times, &py_bits, &nThreads)) {
+        return NULL;
+    }
+    void* obj = get_ptr(py_obj);
+
+    Py_buffer times;
+    Py_buffer bits;
+    if ( ! get_int_buffer(py_times, &times, 4, 0, "times")) {
+        return NULL;
+    }
+    if ( ! get_int_buffer(py_bits, &bits, 4, 0, "bits")) {
+        PyBuffer_Release(&times);
+        return NULL;
+    }
+
+    PyObject* res = NULL;
+    if (times.len != bits.len) {
+        PyErr_SetString(PyExc_ValueError, "times and bits must have the same length");
+    } else {
+        Py_BEGIN_ALLOW_THREADS
+        CAPI_ChainStore_lock(obj);
+        CAPI_ChainStore_append(obj, (uint32_t const*)times.buf, (uint32_t const*)bits.buf, (size_t)(times.len / 4), nThreads);
+        CAPI_ChainStore_unlock(obj);
+        Py_END_ALLOW_THREADS
+        res = Py_None;
+        Py_INCREF(res);
+    }
+
+    PyBuffer_Release(&times);
+    PyBuffer_Release(&bits);
+    return res;
+}
+
+PyObject* PyAPI_ChainStore_truncate(PyObject* self, PyObject* args) {
+    PyObject* py_obj;
+    int nHeight;
+
+    if ( ! PyArg_ParseTuple(args, "Oi", &py_obj, &nHeight)) {
+        return NULL;
+    }
+    void* obj = get_ptr(py_obj);
+
+    int ok;
+    Py_BEGIN_ALLOW_THREADS
+    CAPI_ChainStore_lock(obj);
+    ok = (int64_t)nHeight >= (int64_t)CAPI_ChainStore_get_first_height(obj) - 1;
+    if (ok) {
+        CAPI_ChainStore_truncate(obj, nHeight);
+    }
+    CAPI_ChainStore_unlock(obj);
+    Py_END_ALLOW_THREADS
+    if ( ! ok) {
+        PyErr_SetString(PyExc_IndexError, "height below the chain store's first height - 1");
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+PyObject* PyAPI_ChainStore_get_tip_height(PyObject* self, PyObject* args) {
+    PyObject* py_obj;
+
+    if ( ! PyArg_ParseTuple(args, "O", &py_obj)) {
+        return NULL;
+    }
+    void* obj = get_ptr(py_obj);
+    int res;
+    Py_BEGIN_ALLOW_THREADS
+    CAPI_ChainStore_lock_shared(obj);
+    res = CAPI_ChainStore_get_tip_height(obj);
+    CAPI_ChainStore_unlock_shared(obj);
+    Py_END_ALLOW_THREADS
+    return Py_BuildValue("i", res);
+}
+
+PyObject* PyAPI_ChainStore_next_work_required(PyObject* self, PyObject* args) {
+    PyObject* py_obj;
+    int nPrevHeight;
+    int nRefHeight;
+    PyObject* py_params;
+
+    if ( ! PyArg_ParseTuple(args, "OiiO", &py_obj, &nPrevHeight, &nRefHeight, &py_params)) {
+        return NULL;
+    }
+    void* obj = get_ptr(py_obj);
+    void* params = get_ptr(py_params);
+
+    int ok;
+    uint32_t res = 0;
+    Py_BEGIN_ALLOW_THREADS
+    CAPI_ChainStore_lock_shared(obj);
+    ok = chain_store_heights_valid(obj, nRefHeight, nPrevHeight, nPrevHeight);
+    if (ok) {
+        res = CAPI_ChainStore_next_work_required(obj, nPrevHeight, nRefHeight, params);
+    }
+    CAPI_ChainStore_unlock_shared(obj);
+    Py_END_ALLOW_THREADS
+    if ( ! ok) {
+        return chain_store_heights_error();
+    }
+    return Py_BuildValue("I", res);
+}
+
+PyObject* PyAPI_ChainStore_get_suitable_height(PyObject* self, PyObject* args) {
+    PyObject* py_obj;
+    int nHeight;
+
+    if ( ! PyArg_ParseTuple(args, "Oi", &py_obj, &nHeight)) {
+        return NULL;
+    }
+    void* obj = get_ptr(py_obj);
+
+    int ok;
+    int res = 0;
+    Py_BEGIN_ALLOW_THREADS
+    CAPI_ChainStore_lock_shared(obj);
+    ok = chain_store_heights_valid(obj, nHeight - 2, nHeight, nHeight);
+    if (ok) {
+        res = CAPI_ChainStore_get_suitable_height(obj, nHeight);
+    }
+    CAPI_ChainStore_unlock_shared(obj);
+    Py_END_ALLOW_THREADS
+    if ( ! ok) {
+        return chain_store_heights_error();
+    }
+    return Py_BuildValue("i", res);
+}
+
+// ChainStore_next_work_required_mo3(chain, nPrevHeight, nAnchorHeight, params) -> nBits
+PyObject* PyAPI_ChainStore_next_work_required_mo3(PyObject* self, PyObject* args) {
+    PyObject* py_obj;
+    int nPrevHeight;
+    int nAnchorHeight;
+    PyObject* py_params;
+
+    if ( ! PyArg_ParseTuple(args, "OiiO", &py_obj, &nPrevHeight, &nAnchorHeight, &py_params)) {
+        return NULL;
+    }
+    void* obj = get_ptr(py_obj);
+    void* params = get_ptr(py_params);
+
+    int ok;
+    uint32_t res = 0;
+    Py_BEGIN_ALLOW_THREADS
+    CAPI_ChainStore_lock_shared(obj);
+    // The suitable blocks reach two blocks below the anchor.
+    ok = chain_store_heights_valid(obj, nAnchorHeight - 2, nPrevHeight, nPrevHeight) && nPrevHeight >= nAnchorHeight;
+    if (ok) {
+        res = CAPI_ChainStore_next_work_required_mo3(obj, nPrevHeight, nAnchorHeight, params);
+    }
+    CAPI_ChainStore_unlock_shared(obj);
+    Py_END_ALLOW_THREADS
+    if ( ! ok) {
+        PyErr_SetString(PyExc_IndexError, "heights out of the chain store or below the anchor block");
+        return NULL;
+    }
+    return Py_BuildValue("I", res);
+}
+
+// ChainStore_next_work_required_range(chain, nRefHeight, nFirstPrevHeight, count, params) -> list of nBits
+PyObject* PyAPI_ChainStore_next_work_required_range(PyObject* self, PyObject* args) {
+    PyObject* py_obj;
+    int nRefHeight;
+    int nFirstPrevHeight;
+    Py_ssize_t count;
+    PyObject* py_params;
+
+    if ( ! PyArg_ParseTuple(args, "OiinO", &py_obj, &nRefHeight, &nFirstPrevHeight, &count, &py_params)) {
+        return NULL;
+    }
+    if (count < 0) {
+        PyErr_SetString(PyExc_ValueError, "count must not be negative");
+        return NULL;
+    }
+    void* obj = get_ptr(py_obj);
+    void* params = get_ptr(py_params);
+
+    uint32_t* nBitsOut = (uint32_t*)PyMem_Malloc(sizeof(uint32_t) * (count + 1));
+    if (nBitsOut == NULL) {
+        return PyErr_NoMemory();
+    }
+
+    int ok;
+    Py_BEGIN_ALLOW_THREADS
+    CAPI_ChainStore_lock_shared(obj);
+    ok = count == 0
+      || (chain_store_heights_valid(obj, nRefHeight, nFirstPrevHeight, nFirstPrevHeight)
+          && chain_store_range_valid(obj, nFirstPrevHeight, count));
+    if (ok) {
+        CAPI_ChainStore_next_work_required_range(obj, nRefHeight, nFirstPrevHeight, (size_t)count, params, nBitsOut);
+    }
+    CAPI_ChainStore_unlock_shared(obj);
+    Py_END_ALLOW_THREADS
+    if ( ! ok) {
+        PyMem_Free(nBitsOut);
+        return chain_store_heights_error();
+    }
+
+    PyObject* res = bits_to_list(nBitsOut, count);
+    PyMem_Free(nBitsOut);
+    return res;
+}
+
+// ChainStore_next_work_required_range_into(chain, nRefHeight, nFirstPrevHeight, params, out)
+// As ChainStore_next_work_required_range, for as many blocks as out, a
+// writable buffer of 4 byte integers, has.
+PyObject* PyAPI_ChainStore_next_work_required_range_into(PyObject* self, PyObject* args) {
+    PyObject* py_obj;
+    int nRefHeight;
+    int nFirstPrevHeight;
+    PyObject* py_params;
+    PyObject* py_out;
+
+    if ( ! PyArg_ParseTuple(args, "OiiOO", &py_obj, &nRefHeight, &nFirstPrevHeight, &py_params, &py_out)) {
+        return NULL;
+    }
+    void* obj = get_ptr(py_obj);
+    void* params = get_ptr(py_params);
+
+    Py_buffer out;
+    if ( ! get_int_buffer(py_out, &out, 4, 1, "out")) {
+        return NULL;
+    }
+    Py_ssize_t count = out.len / 4;
+
+    int ok;
+    Py_BEGIN_ALLOW_THREADS
+    CAPI_ChainStore_lock_shared(obj);
+    ok = count == 0
+      || (chain_store_heights_valid(obj, nRefHeight, nFirstPrevHeight, nFirstPrevHeight)
+          && chain_store_range_valid(obj, nFirstPrevHeight, count));
+    if (ok) {
+        CAPI_ChainStore_next_work_required_range(obj, nRefHeight, nFirstPrevHeight, (size_t)count, params, (uint32_t*)out.buf);
+    }
+    CAPI_ChainStore_unlock_shared(obj);
+    Py_END_ALLOW_THREADS
+
+    PyBuffer_Release(&out);
+    if ( ! ok) {
+        return chain_store_heights_error();
+    }
+    Py_RETURN_NONE;
+}
+
+// ChainStore_find_first_bits_mismatch(chain, nRefHeight, nFirstHeight, params[, threads])
+//     -> lowest height in [nFirstHeight, tip] whose nBits is not the ASERT one, None if none
+PyObject* PyAPI_ChainStore_find_first_bits_mismatch(PyObject* self, PyObject* args) {
+    PyObject* py_obj;
+    int nRefHeight;
+    int nFirstHeight;
+    PyObject* py_params;
+    unsigned int nThreads = 0;
+
+    if ( ! PyArg_ParseTuple(args, "OiiO|I", &py_obj, &nRefHeight, &nFirstHeight, &py_params, &nThreads)) {
+        return NULL;
+    }
+    void* obj = get_ptr(py_obj);
+    void* params = get_ptr(py_params);
+
+    int ok;
+    int res = -1;
+    Py_BEGIN_ALLOW_THREADS
+    CAPI_ChainStore_lock_shared(obj);
+    ok = nFirstHeight > nRefHeight && chain_store_heights_valid(obj, nRefHeight, nRefHeight, nRefHeight);
+    if (ok) {
+        res = CAPI_ChainStore_find_first_bits_mismatch(obj, nRefHeight, nFirstHeight, params, nThreads);
+    }
+    CAPI_ChainStore_unlock_shared(obj);
+    Py_END_ALLOW_THREADS
+    if ( ! ok) {
+        PyErr_SetString(PyExc_IndexError, "reference block out of the chain store or not below the first height");
+        return NULL;
+    }
+
+    if (res < 0) {
+        Py_RETURN_NONE;
+    }
+    return Py_BuildValue("i", res);
+}
+
+// ChainStore_load_headers(chain, path) -> number of headers appended
+PyObject* PyAPI_ChainStore_load_headers(PyObject* self, PyObject* args) {
+    PyObject* py_obj;
+    char const* path;
+
+    if ( ! PyArg_ParseTuple(args, "Os", &py_obj, &path)) {
+        return NULL;
+    }
+    void* obj = get_ptr(py_obj);
+
+    char error[512];
+    int ok;
+    int nAppended;
+    Py_BEGIN_ALLOW_THREADS
+    CAPI_ChainStore_lock(obj);
+    int nTipHeight = CAPI_ChainStore_get_tip_height(obj);
+    ok = CAPI_ChainStore_load_headers(obj, path, error, sizeof(error));
+    nAppended = CAPI_ChainStore_get_tip_height(obj) - nTipHeight;
+    CAPI_ChainStore_unlock(obj);
+    Py_END_ALLOW_THREADS
+
+    if ( ! ok) {
+        PyErr_SetString(PyExc_OSError, error);
+        return NULL;
+    }
+    return Py_BuildValue("i", nAppended);
+}
+
+// ChainStore_append_headers(chain, headers[, threads]) -> number of headers appended
+// headers is a buffer of serialized headers, back to back, as in a raw header dump.
+PyObject* PyAPI_ChainStore_append_headers(PyObject* self, PyObject* args) {
+    PyObject* py_obj;
+    PyObject* py_headers;
+    unsigned int nThreads = 1;
+
+    if ( ! PyArg_ParseTuple(args, "OO|I", &py_obj, &py_headers, &nThreads)) {
+        return NULL;
+    }
+    void* obj = get_ptr(py_obj);
+
+    Py_buffer headers;
+    if ( ! get_headers_buffer(py_headers, &headers, "headers")) {
+        return NULL;
+    }
+    size_t count = (size_t)(headers.len / 80);
+
+    Py_BEGIN_ALLOW_THREADS
+    CAPI_ChainStore_lock(obj);
+    CAPI_ChainStore_append_headers(obj, (uint8_t const*)headers.buf, count, nThreads);
+    CAPI_ChainStore_unlock(obj);
+    Py_END_ALLOW_THREADS
+
+    PyBuffer_Release(&headers);
+    return Py_BuildValue("n", (Py_ssize_t)count);
+}
+
+// 32 little endian bytes as a Python int.
+static PyObject* uint256_to_pylong(uint8_t const* le) {
+    char hex[65];
+    for (int i = 0; i < 32; ++i) {
+        snprintf(hex + 2 * i, 3, "%02x", le[31 - i]);
+    }
+    return PyLong_FromString(hex, NULL, 16);
+}
+
+// ChainStore_enable_chain_work(chain[, threads])
+PyObject* PyAPI_ChainStore_enable_chain_work(PyObject* self, PyObject* args) {
+    PyObject* py_obj;
+    unsigned int nThreads = 1;
+
+    if ( ! PyArg_ParseTuple(args, "O|I", &py_obj, &nThreads)) {
+        return NULL;
+    }
+    void* obj = get_ptr(py_obj);
+
+    Py_BEGIN_ALLOW_THREADS
+    CAPI_ChainStore_lock(obj);
+    CAPI_ChainStore_enable_chain_work(obj, nThreads);
+    CAPI_ChainStore_unlock(obj);
+    Py_END_ALLOW_THREADS
+
+    Py_RETURN_NONE;
+}
+
+// ChainStore_get_chain_work(chain, nHeight) -> chain work up to and including nHeight
+PyObject* PyAPI_ChainStore_get_chain_work(PyObject* self, PyObject* args) {
+    PyObject* py_obj;
+    int nHeight;
+
+    if ( ! PyArg_ParseTuple(args, "Oi", &py_obj, &nHeight)) {
+        return NULL;
+    }
+    void* obj = get_ptr(py_obj);
+
+    int fInStore;
+    int fHasWork = 0;
+    uint8_t work[32];
+    Py_BEGIN_ALLOW_THREADS
+    CAPI_ChainStore_lock_shared(obj);
+    fInStore = nHeight >= CAPI_ChainStore_get_first_height(obj) && nHeight <= CAPI_ChainStore_get_tip_height(obj);
+    if (fInStore) {
+        fHasWork = CAPI_ChainStore_get_chain_work(obj, nHeight, work);
+    }
+    CAPI_ChainStore_unlock_shared(obj);
+    Py_END_ALLOW_THREADS
+
+    if ( ! fInStore) {
+        PyErr_SetString(PyExc_IndexError, "height out of the chain store");
+        return NULL;
+    }
+    if ( ! fHasWork) {
+        PyErr_SetString(PyExc_ValueError, "the chain store does not keep chain work");
+        return NULL;
+    }
+    return uint256_to_pylong(work);
+}
+
+// Proof of work -----------------------------------------------------------------
+
+// GetBlockProof(nBits) -> 2**256 // (target + 1), 0 for an invalid target
+PyObject* PyAPI_GetBlockProof(PyObject* self, PyObject* args) {
+    uint32_t nBits;
+
+    if ( ! PyArg_ParseTuple(args, "I", &nBits)) {
+        return NULL;
+    }
+
+    uint8_t proof[32];
+    CAPI_GetBlockProof(nBits, proof);
+    return uint256_to_pylong(proof);
+}
+
+// HeaderFile_find_first_invalid_pow(path, params)
+//     -> index of the first header of a raw header dump failing CheckProofOfWork, None if none
+PyObject* PyAPI_HeaderFile_find_first_invalid_pow(PyObject* self, PyObject* args) {
+    char const* path;
+    PyObject* py_params;
+
+    if ( ! PyArg_ParseTuple(args, "sO", &path, &py_params)) {
+        return NULL;
+    }
+    void* params = get_ptr(py_params);
+
+    char error[512];
+    size_t index;
+    size_t count;
+    int ok;
+    Py_BEGIN_ALLOW_THREADS
+    ok = CAPI_HeaderFile_find_first_invalid_pow(path, params, &index, &count, error, sizeof(error));
+    Py_END_ALLOW_THREADS
+
+    if ( ! ok) {
+        PyErr_SetString(PyExc_OSError, error);
+        return NULL;
+    }
+    if (index == count) {
+        Py_RETURN_NONE;
+    }
+    return Py_BuildValue("n", (Py_ssize_t)index);
+}
+
+// Headers_find_first_invalid_pow(headers, params)
+//     -> index of the first header of a buffer of serialized headers failing CheckProofOfWork, None if none
+PyObject* PyAPI_Headers_find_first_invalid_pow(PyObject* self, PyObject* args) {
+    PyObject* py_headers;
+    PyObject* py_params;
+
+    if ( ! PyArg_ParseTuple(args, "OO", &py_headers, &py_params)) {
+        return NULL;
+    }
+    void* params = get_ptr(py_params);
+
+    Py_buffer headers;
+    if ( ! get_headers_buffer(py_headers, &headers, "headers")) {
+        return NULL;
+    }
+    size_t count = (size_t)(headers.len / 80);
+
+    size_t index;
+    Py_BEGIN_ALLOW_THREADS
+    index = CAPI_Headers_find_first_invalid_pow((uint8_t const*)headers.buf, count, params);
+    Py_END_ALLOW_THREADS
+
+    PyBuffer_Release(&headers);
+    if (index == count) {
+        Py_RETURN_NONE;
+    }
+    return Py_BuildValue("n", (Py_ssize_t)index);
+}
+
+// SHA256d_headers_into(headers, out)
+// Block hashes of a buffer of serialized headers, 32 bytes each in uint256
+// byte order, to a writable buffer of 32 bytes per header.
+PyObject* PyAPI_SHA256d_headers_into(PyObject* self, PyObject* args) {
+    PyObject* py_headers;
+    PyObject* py_out;
+
+    if ( ! PyArg_ParseTuple(args, "OO", &py_headers, &py_out)) {
+        return NULL;
+    }
+
+    Py_buffer headers;
+    Py_buffer out;
+    if ( ! get_headers_buffer(py_headers, &headers, "headers")) {
+        return NULL;
+    }
+    if (PyObject_GetBuffer(py_out, &out, PyBUF_C_CONTIGUOUS | PyBUF_WRITABLE) != 0) {
+        PyBuffer_Release(&headers);
+        return NULL;
+    }
+
+    PyObject* res = NULL;
+    size_t count = (size_t)(headers.len / 80);
+    if (out.len != (Py_ssize_t)(count * 32)) {
+        PyErr_SetString(PyExc_ValueError, "out must have 32 bytes per header");
+    } else {
+        Py_BEGIN_ALLOW_THREADS
+        CAPI_SHA256d_headers((uint8_t const*)headers.buf, count, (uint8_t*)out.buf);
+        Py_END_ALLOW_THREADS
+        res = Py_None;
+        Py_INCREF(res);
+    }
+
+    PyBuffer_Release(&headers);
+    PyBuffer_Release(&out);
+    return res;
+}
+
+// Difficulty algorithms --------------------------------------------------------
+
+PyObject* PyAPI_DAA_names(PyObject* self, PyObject* args) {
+    size_t count = CAPI_DAA_count();
+    PyObject* res = PyList_New((Py_ssize_t)count);
+    if (res == NULL) {
+        return NULL;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        PyObject* name = PyUnicode_FromString(CAPI_DAA_name(i));
+        if (name == NULL) {
+            Py_DECREF(res);
+            return NULL;
+        }
+        PyList_SET_ITEM(res, (Py_ssize_t)i, name);
+    }
+    return res;
+}
+
+// Resolves name. Sets the Python error and returns NULL if it is unknown.
+static void const* get_daa(char const* name) {
+    void const* daa = CAPI_DAA_get(name);
+    if (daa == NULL) {
+        PyErr_Format(PyExc_ValueError, "unknown difficulty algorithm %s", name);
+    }
+    return daa;
+}
+
+// Whether nPrevHeight is in the chain store and at or above the algorithm's
+// minimum, with the chain store's lock held.
+static int daa_height_valid(void const* daa, void const* chain, int nPrevHeight) {
+    return nPrevHeight >= CAPI_DAA_get_min_prev_height(daa, chain)
+        && nPrevHeight <= CAPI_ChainStore_get_tip_height(chain);
+}
+
+static PyObject* daa_heights_error(char const* name) {
+    PyErr_Format(PyExc_IndexError, "heights out of the chain store or below the first one %s can compute", name);
+    return NULL;
+}
+
+// DAA_next_work_required(chain, name, nPrevHeight, params) -> nBits
+PyObject* PyAPI_DAA_next_work_required(PyObject* self, PyObject* args) {
+    PyObject* py_obj;
+    char const* name;
+    int nPrevHeight;
+    PyObject* py_params;
+
+    if ( ! PyArg_ParseTuple(args, "OsiO", &py_obj, &name, &nPrevHeight, &py_params)) {
+        return NULL;
+    }
+    void* obj = get_ptr(py_obj);
+    void* params = get_ptr(py_params);
+    void const* daa = get_daa(name);
+    if (daa == NULL) {
+        return NULL;
+    }
+
+    int ok;
+    uint32_t res = 0;
+    Py_BEGIN_ALLOW_THREADS
+    CAPI_ChainStore_lock_shared(obj);
+    ok = daa_height_valid(daa, obj, nPrevHeight);
+    if (ok) {
+        res = CAPI_DAA_next_work_required(daa, obj, nPrevHeight, params);
+    }
+    CAPI_ChainStore_unlock_shared(obj);
+    Py_END_ALLOW_THREADS
+    if ( ! ok) {
+        return daa_heights_error(name);
+    }
+    return Py_BuildValue("I", res);
+}
+
+// DAA_next_work_required_range(chain, name, nFirstPrevHeight, count, params) -> list of nBits
+PyObject* PyAPI_DAA_next_work_required_range(PyObject* self, PyObject* args) {
+    PyObject* py_obj;
+    char const* name;
+    int nFirstPrevHeight;
+    Py_ssize_t count;
+    PyObject* py_params;
+
+    if ( ! PyArg_ParseTuple(args, "OsinO", &py_obj, &name, &nFirstPrevHeight, &count, &py_params)) {
+        return NULL;
+    }
+    if (count < 0) {
+        PyErr_SetString(PyExc_ValueError, "count must not be negative");
+        return NULL;
+    }
+    void* obj = get_ptr(py_obj);
+    void* params = get_ptr(py_params);
+    void const* daa = get_daa(name);
+    if (daa == NULL) {
+        return NULL;
+    }
+
+    uint32_t* nBitsOut = (uint32_t*)PyMem_Malloc(sizeof(uint32_t) * (count + 1));
+    if (nBitsOut == NULL) {
+        return PyErr_NoMemory();
+    }
+
+    int ok;
+    Py_BEGIN_ALLOW_THREADS
+    CAPI_ChainStore_lock_shared(obj);
+    ok = daa_height_valid(daa, obj, nFirstPrevHeight)
+      && chain_store_range_valid(obj, nFirstPrevHeight, count);
+    if (ok) {
+        CAPI_DAA_next_work_required_range(daa, obj, nFirstPrevHeight, (size_t)count, params, nBitsOut);
+    }
+    CAPI_ChainStore_unlock_shared(obj);
+    Py_END_ALLOW_THREADS
+    if ( ! ok) {
+        PyMem_Free(nBitsOut);
+        return daa_heights_error(name);
+    }
+
+    PyObject* res = bits_to_list(nBitsOut, count);
+    PyMem_Free(nBitsOut);
+    return res;
+}
+
+// DAA_next_work_required_range_into(chain, name, nFirstPrevHeight, params, out)
+// As DAA_next_work_required_range, for as many blocks as out, a writable
+// buffer of 4 byte integers, has.
+PyObject* PyAPI_DAA_next_work_required_range_into(PyObject* self, PyObject* args) {
+    PyObject* py_obj;
+    char const* name;
+    int nFirstPrevHeight;
+    PyObject* py_params;
+    PyObject* py_out;
+
+    if ( ! PyArg_ParseTuple(args, "OsiOO", &py_obj, &name, &nFirstPrevHeight, &py_params, &py_out)) {
+        return NULL;
+    }
+    void* obj = get_ptr(py_obj);
+    void* params = get_ptr(py_params);
+
+    Py_buffer out;
+    if ( ! get_int_buffer(py_out, &out, 4, 1, "out")) {
+        return NULL;
+    }
+    Py_ssize_t count = out.len / 4;
+    void const* daa = get_daa(name);
+    if (daa == NULL) {
+        PyBuffer_Release(&out);
+        return NULL;
+    }
+
+    int ok;
+    Py_BEGIN_ALLOW_THREADS
+    CAPI_ChainStore_lock_shared(obj);
+    ok = daa_height_valid(daa, obj, nFirstPrevHeight)
+      && chain_store_range_valid(obj, nFirstPrevHeight, count);
+    if (ok) {
+        CAPI_DAA_next_work_required_range(daa, obj, nFirstPrevHeight, (size_t)count, params, (uint32_t*)out.buf);
+    }
+    CAPI_ChainStore_unlock_shared(obj);
+    Py_END_ALLOW_THREADS
+
+    PyBuffer_Release(&out);
+    if ( ! ok) {
+        return daa_heights_error(name);
+    }
+    Py_RETURN_NONE;
+}
+
+// Simulation --------------------------------------------------------
+
+// RunSimulations(params, scenario, consensus_params, seed, count[, threads[, algo]])
+// params is a mining.py style dict: its numeric entries override the
+// defaults, the rest (algo, scenario, ...) is ignored. algo is one of
+// DAA_names(), aserti3-416-cpp by default.
+// Returns {"mean"|"stdev"|"median"|"max": (min, max, mean, stdev, median)}.
+PyObject* PyAPI_RunSimulations(PyObject* self, PyObject* args) {
+    PyObject* py_simul_params;
+    char const* scenario;
+    PyObject* py_params;
+    unsigned long long seed;
+    Py_ssize_t count;
+    unsigned int nThreads = 0;
+    char const* algo = "aserti3-416-cpp";
+
+    if ( ! PyArg_ParseTuple(args, "O!sOKn|Is", &PyDict_Type, &py_simul_params, &scenario, &py_params, &seed, &count, &nThreads, &algo)) {
+        return NULL;
+    }
+    if (count < 1) {
+        PyErr_SetString(PyExc_ValueError, "count must be positive");
+        return NULL;
+    }
+
+    void* params = get_ptr(py_params);
+    void* simul = CAPI_SimulParams_construct();
+
+    PyObject* key;
+    PyObject* value;
+    Py_ssize_t pos = 0;
+    while (PyDict_Next(py_simul_params, &pos, &key, &value)) {
+        if ( ! PyUnicode_Check(key) || PyBool_Check(value) || ! (PyLong_Check(value) || PyFloat_Check(value))) {
+            continue;
+        }
+        char const* name = PyUnicode_AsUTF8(key);
+        double number = PyFloat_AsDouble(value);
+        if (name == NULL || PyErr_Occurred()) {
+            CAPI_SimulParams_destruct(simul);
+            return NULL;
+        }
+        CAPI_SimulParams_set(simul, name, number);
+    }
+    if ( ! CAPI_SimulParams_set_algo(simul, algo)) {
+        CAPI_SimulParams_destruct(simul);
+        PyErr_Format(PyExc_ValueError, "unknown difficulty algorithm %s", algo);
+        return NULL;
+    }
+
+    double summary[20];
+    int ok;
+    Py_BEGIN_ALLOW_THREADS
+    ok = CAPI_RunSimulations(simul, scenario, params, seed, (size_t)count, nThreads, summary);
+    Py_END_ALLOW_THREADS
+    CAPI_SimulParams_destruct(simul);
+
+    if ( ! ok) {
+        PyErr_SetString(PyExc_ValueError, "unknown scenario or simulation parameters out of range");
+        return NULL;
+    }
+
+    return Py_BuildValue("{s:(ddddd),s:(ddddd),s:(ddddd),s:(ddddd)}",
+                         "mean", summary[0], summary[1], summary[2], summary[3], summary[4],
+                         "stdev", summary[5], summary[6], summary[7], summary[8], summary[9],
+                         "median", summary[10], summary[11], summary[12], summary[13], summary[14],
+                         "max", summary[15], summary[16], summary[17], summary[18], summary[19]);
+}
+
 #ifdef __cplusplus
 } // extern "C"
 #endif  
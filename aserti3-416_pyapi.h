@@ -15,6 +15,8 @@ PyObject* PyAPI_CBlockIndex_get_nHeight(PyObject* self, PyObject* args);
 PyObject* PyAPI_CBlockIndex_set_nTime(PyObject* self, PyObject* args);
 PyObject* PyAPI_CBlockIndex_set_nBits(PyObject* self, PyObject* args);
 PyObject* PyAPI_CBlockIndex_set_pprev(PyObject* self, PyObject* args);
+PyObject* PyAPI_CBlockIndex_link(PyObject* self, PyObject* args);
+PyObject* PyAPI_CBlockIndex_GetAncestor(PyObject* self, PyObject* args);
 PyObject* PyAPI_CBlockIndex_set_nChainWork(PyObject* self, PyObject* args);
 
 // class CBlockHeader --------------------------------------------------------
@@ -28,9 +30,56 @@ PyObject* PyAPI_arith_uint256_destruct(PyObject* self, PyObject* args);
 // Parameters --------------------------------------------------------
 PyObject* PyAPI_Params_GetDefaultMainnetConsensusParams(PyObject* self, PyObject* args);
 PyObject* PyAPI_Params_destruct(PyObject* self, PyObject* args);
+PyObject* PyAPI_Params_set_powLimit(PyObject* self, PyObject* args);
+PyObject* PyAPI_Params_set_nDAAHalfLife(PyObject* self, PyObject* args);
+PyObject* PyAPI_Params_set_nPowTargetSpacing(PyObject* self, PyObject* args);
+PyObject* PyAPI_Params_set_fPowAllowMinDifficultyBlocks(PyObject* self, PyObject* args);
 
 // GetNextASERTWorkRequired --------------------------------------------------------
 PyObject* PyAPI_GetNextASERTWorkRequired(PyObject* self, PyObject* args);
+PyObject* PyAPI_GetSuitableBlock(PyObject* self, PyObject* args);
+PyObject* PyAPI_GetNextASERTMo3WorkRequired(PyObject* self, PyObject* args);
+PyObject* PyAPI_CalculateASERTBatch(PyObject* self, PyObject* args);
+PyObject* PyAPI_CalculateASERTBatch_into(PyObject* self, PyObject* args);
+
+// class ASERTChain --------------------------------------------------------
+PyObject* PyAPI_ASERTChain_construct(PyObject* self, PyObject* args);
+PyObject* PyAPI_ASERTChain_destruct(PyObject* self, PyObject* args);
+PyObject* PyAPI_ASERTChain_append(PyObject* self, PyObject* args);
+PyObject* PyAPI_ASERTChain_next_work_required(PyObject* self, PyObject* args);
+
+// class CChainStore --------------------------------------------------------
+PyObject* PyAPI_ChainStore_construct(PyObject* self, PyObject* args);
+PyObject* PyAPI_ChainStore_destruct(PyObject* self, PyObject* args);
+PyObject* PyAPI_ChainStore_push_back(PyObject* self, PyObject* args);
+PyObject* PyAPI_ChainStore_append(PyObject* self, PyObject* args);
+PyObject* PyAPI_ChainStore_truncate(PyObject* self, PyObject* args);
+PyObject* PyAPI_ChainStore_get_tip_height(PyObject* self, PyObject* args);
+PyObject* PyAPI_ChainStore_next_work_required(PyObject* self, PyObject* args);
+PyObject* PyAPI_ChainStore_get_suitable_height(PyObject* self, PyObject* args);
+PyObject* PyAPI_ChainStore_next_work_required_mo3(PyObject* self, PyObject* args);
+PyObject* PyAPI_ChainStore_next_work_required_range(PyObject* self, PyObject* args);
+PyObject* PyAPI_ChainStore_next_work_required_range_into(PyObject* self, PyObject* args);
+PyObject* PyAPI_ChainStore_find_first_bits_mismatch(PyObject* self, PyObject* args);
+PyObject* PyAPI_ChainStore_load_headers(PyObject* self, PyObject* args);
+PyObject* PyAPI_ChainStore_append_headers(PyObject* self, PyObject* args);
+PyObject* PyAPI_ChainStore_enable_chain_work(PyObject* self, PyObject* args);
+PyObject* PyAPI_ChainStore_get_chain_work(PyObject* self, PyObject* args);
+
+// Proof of work -----------------------------------------------------------------
+PyObject* PyAPI_GetBlockProof(PyObject* self, PyObject* args);
+PyObject* PyAPI_HeaderFile_find_first_invalid_pow(PyObject* self, PyObject* args);
+PyObject* PyAPI_Headers_find_first_invalid_pow(PyObject* self, PyObject* args);
+PyObject* PyAPI_SHA256d_headers_into(PyObject* self, PyObject* args);
+
+// Difficulty algorithms --------------------------------------------------------
+PyObject* PyAPI_DAA_names(PyObject* self, PyObject* args);
+PyObject* PyAPI_DAA_next_work_required(PyObject* self, PyObject* args);
+PyObject* PyAPI_DAA_next_work_required_range(PyObject* self, PyObject* args);
+PyObject* PyAPI_DAA_next_work_required_range_into(PyObject* self, PyObject* args);
+
+// Simulation --------------------------------------------------------
+PyObject* PyAPI_RunSimulations(PyObject* self, PyObject* args);
 
 #ifdef __cplusplus
 } // extern "C"
@@ -0,0 +1,189 @@
+/**
+ * Copyright (c) 2020 Fernando Pelliccioni
+ */
+
+// Batch exponential sampler on top of Philox4x32.
+//
+// The kernel is plain lane-parallel C++: a group of counters goes through the
+// ten Philox rounds side by side, then through a branch-free logarithm, which
+// the compiler vectorizes. The logarithm is fdlibm's __ieee754_log (error
+// below 1 ulp) restricted to the positive normal inputs 1 - u can take, with
+// both of its final formulas computed and one selected, so the scalar and AVX2
+// builds of the same code return the same bits.
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+#include "aserti3-416_random.hpp"
+
+namespace {
+
+// Counters transformed per kernel iteration.
+constexpr size_t nLanes = 8;
+
+__attribute__((always_inline))
+inline double LogPositiveNormal(double x) {
+    constexpr double ln2_hi = 6.93147180369123816490e-01;
+    constexpr double ln2_lo = 1.90821492927058770002e-10;
+    constexpr double Lg1 = 6.666666666666735130e-01;
+    constexpr double Lg2 = 3.999999999940941908e-01;
+    constexpr double Lg3 = 2.857142874366239149e-01;
+    constexpr double Lg4 = 2.222219843214978396e-01;
+    constexpr double Lg5 = 1.818357216161805012e-01;
+    constexpr double Lg6 = 1.531383769920937332e-01;
+    constexpr double Lg7 = 1.479819860511658591e-01;
+
+    uint64_t ix;
+    std::memcpy(&ix, &x, sizeof(ix));
+    const int32_t hx = int32_t((ix >> 32) & 0x000fffff);
+    const int32_t i = (hx + 0x95f64) & 0x100000;
+    // Normalize x or x / 2 so that the mantissa is in [sqrt(2)/2, sqrt(2)).
+    const uint64_t im = (ix & 0x000fffffffffffff) | (uint64_t(i ^ 0x3ff00000) << 32);
+    double m;
+    std::memcpy(&m, &im, sizeof(m));
+    const int32_t k = int32_t(ix >> 52) - 1023 + (i >> 20);
+
+    const double f = m - 1.0;
+    const double dk = double(k);
+    const double s = f / (2.0 + f);
+    const double z = s * s;
+    const double w = z * z;
+    const double t1 = w * (Lg2 + w * (Lg4 + w * Lg6));
+    const double t2 = z * (Lg1 + w * (Lg3 + w * (Lg5 + w * Lg7)));
+    const double R = t2 + t1;
+    const double hfsq = 0.5 * f * f;
+    const double near1 = dk * ln2_hi - ((s * (f - R) - dk * ln2_lo) - f);
+    const double far1 = dk * ln2_hi - ((hfsq - (s * (hfsq + R) + dk * ln2_lo)) - f);
+
+    // Select with a mask rather than a branch so that the loop vectorizes.
+    const uint64_t mask = uint64_t(0) - uint64_t(((hx - 0x6147a) | (0x6b851 - hx)) > 0);
+    uint64_t inear, ifar;
+    std::memcpy(&inear, &near1, sizeof(inear));
+    std::memcpy(&ifar, &far1, sizeof(ifar));
+    const uint64_t ir = (ifar & mask) | (inear & ~mask);
+    double r;
+    std::memcpy(&r, &ir, sizeof(r));
+    return r;
+}
+
+// Exact double of an integer below 2^52: 2^52 + x has x as its mantissa.
+__attribute__((always_inline))
+inline double SmallToDouble(uint64_t x) {
+    constexpr double two52 = 4503599627370496.0;
+    const uint64_t ix = 0x4330000000000000 | x;
+    double d;
+    std::memcpy(&d, &ix, sizeof(d));
+    return d - two52;
+}
+
+__attribute__((always_inline))
+inline double ExponentialFromBits(uint64_t bits) {
+    // double(bits >> 11) assembled from two halves, since there is no vector
+    // uint64 -> double conversion before AVX-512.
+    const uint64_t x = bits >> 11;
+    const double dx = SmallToDouble(x >> 32) * 4294967296.0 + SmallToDouble(x & 0xffffffff);
+    const double u = dx * (1.0 / 9007199254740992.0);
+    return -LogPositiveNormal(1.0 - u);
+}
+
+// Writes 2 * nCounters variates for the counters [nFirst, nFirst + nCounters).
+__attribute__((always_inline))
+inline void ExponentialKernel(const uint32_t key[2], uint64_t nStream, uint64_t nFirst,
+                              size_t nCounters, double *out) {
+    for (size_t begin = 0; begin < nCounters; begin += nLanes) {
+        const size_t n = nCounters - begin < nLanes ? nCounters - begin : nLanes;
+        uint32_t c0[nLanes], c1[nLanes], c2[nLanes], c3[nLanes];
+        for (size_t l = 0; l < nLanes; ++l) {
+            const uint64_t nCounter = nFirst + begin + l;
+            c0[l] = uint32_t(nCounter);
+            c1[l] = uint32_t(nCounter >> 32);
+            c2[l] = uint32_t(nStream);
+            c3[l] = uint32_t(nStream >> 32);
+        }
+        uint32_t k0 = key[0], k1 = key[1];
+        for (int round = 0; round < 10; ++round) {
+            for (size_t l = 0; l < nLanes; ++l) {
+                const uint64_t p0 = uint64_t(0xD2511F53) * c0[l];
+                const uint64_t p1 = uint64_t(0xCD9E8D57) * c2[l];
+                const uint32_t n0 = uint32_t(p1 >> 32) ^ c1[l] ^ k0;
+                const uint32_t n2 = uint32_t(p0 >> 32) ^ c3[l] ^ k1;
+                c1[l] = uint32_t(p1);
+                c3[l] = uint32_t(p0);
+                c0[l] = n0;
+                c2[l] = n2;
+            }
+            k0 += 0x9E3779B9;
+            k1 += 0xBB67AE85;
+        }
+        uint64_t bits[2 * nLanes];
+        for (size_t l = 0; l < nLanes; ++l) {
+            bits[2 * l] = uint64_t(c0[l]) | uint64_t(c1[l]) << 32;
+            bits[2 * l + 1] = uint64_t(c2[l]) | uint64_t(c3[l]) << 32;
+        }
+        double e[2 * nLanes];
+        for (size_t l = 0; l < 2 * nLanes; ++l) {
+            e[l] = ExponentialFromBits(bits[l]);
+        }
+        std::memcpy(out + 2 * begin, e, 2 * n * sizeof(double));
+    }
+}
+
+void ExponentialScalar(const uint32_t key[2], uint64_t nStream, uint64_t nFirst,
+                       size_t nCounters, double *out) noexcept {
+    ExponentialKernel(key, nStream, nFirst, nCounters, out);
+}
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define RANDOM_X86_SIMD 1
+
+// AVX2 only, without FMA: contracting the multiply-adds would change the bits.
+__attribute__((target("avx2")))
+void ExponentialAVX2(const uint32_t key[2], uint64_t nStream, uint64_t nFirst,
+                     size_t nCounters, double *out) noexcept {
+    ExponentialKernel(key, nStream, nFirst, nCounters, out);
+}
+#endif
+
+using ExponentialFn = void (*)(const uint32_t *, uint64_t, uint64_t, size_t, double *) noexcept;
+
+struct Kernel {
+    ExponentialFn fn;
+    const char *name;
+};
+
+Kernel SelectKernel() {
+#if defined(RANDOM_X86_SIMD)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return {ExponentialAVX2, "avx2"};
+    }
+#endif
+    return {ExponentialScalar, "scalar"};
+}
+
+const Kernel kernel = SelectKernel();
+
+} // namespace
+
+void SampleExponential(Philox4x32 &rng, double *out, size_t count) noexcept {
+    size_t i = 0;
+
+    // Finish the counter the generator is in the middle of.
+    if (count > 0 && (rng.Position() & 1) != 0) {
+        out[i++] = ExponentialFromBits(rng());
+    }
+
+    const size_t nCounters = (count - i) / 2;
+    kernel.fn(rng.Key(), rng.Stream(), rng.Position() >> 1, nCounters, out + i);
+    rng.Discard(2 * nCounters);
+    i += 2 * nCounters;
+
+    if (i < count) {
+        out[i] = ExponentialFromBits(rng());
+    }
+}
+
+const char *SampleExponentialKernelName() noexcept {
+    return kernel.name;
+}
@@ -0,0 +1,109 @@
+#ifndef ASERTI3_416_RANDOM_HPP_
+#define ASERTI3_416_RANDOM_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+/**
+ * Philox4x32-10 counter-based generator (Salmon et al., "Parallel Random
+ * Numbers: As Easy as 1, 2, 3", SC'11).
+ *
+ * Output i of a stream is a pure function of (seed, stream, i): streams are
+ * independent, any position is reachable in O(1) (Discard), and results do
+ * not depend on how work is split across threads.
+ * Each counter yields two 64-bit outputs.
+ */
+class Philox4x32 {
+public:
+    using result_type = uint64_t;
+
+    Philox4x32(uint64_t seed, uint64_t stream) noexcept
+        : key {uint32_t(seed), uint32_t(seed >> 32)}
+        , nStream(stream)
+    {}
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    result_type operator()() noexcept {
+        const uint64_t nCounter = nPosition >> 1;
+        if (nCounter != nBufferCounter) {
+            uint32_t out[4];
+            Block(key, nCounter, nStream, out);
+            buffer[0] = uint64_t(out[0]) | uint64_t(out[1]) << 32;
+            buffer[1] = uint64_t(out[2]) | uint64_t(out[3]) << 32;
+            nBufferCounter = nCounter;
+        }
+        return buffer[nPosition++ & 1];
+    }
+
+    /** Skips n outputs. */
+    void Discard(uint64_t n) noexcept { nPosition += n; }
+
+    /** Index of the next output within the stream. */
+    uint64_t Position() const noexcept { return nPosition; }
+
+    /** Uniform in [0, 1) with 53 random bits. */
+    double Uniform() noexcept {
+        return double((*this)() >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    /** Uniform in [0, n), n > 0, unbiased (Lemire's multiply-shift with rejection). */
+    uint64_t Below(uint64_t n) noexcept {
+        unsigned __int128 m = (unsigned __int128)(*this)() * n;
+        if (uint64_t(m) < n) {
+            const uint64_t threshold = -n % n;
+            while (uint64_t(m) < threshold) {
+                m = (unsigned __int128)(*this)() * n;
+            }
+        }
+        return uint64_t(m >> 64);
+    }
+
+    /** Philox4x32-10 of the counter (nCounter, nStream) under key. */
+    static void Block(const uint32_t key[2], uint64_t nCounter, uint64_t nStream, uint32_t out[4]) noexcept {
+        uint32_t c0 = uint32_t(nCounter), c1 = uint32_t(nCounter >> 32);
+        uint32_t c2 = uint32_t(nStream), c3 = uint32_t(nStream >> 32);
+        uint32_t k0 = key[0], k1 = key[1];
+        for (int round = 0; round < 10; ++round) {
+            const uint64_t p0 = uint64_t(0xD2511F53) * c0;
+            const uint64_t p1 = uint64_t(0xCD9E8D57) * c2;
+            const uint32_t n0 = uint32_t(p1 >> 32) ^ c1 ^ k0;
+            const uint32_t n2 = uint32_t(p0 >> 32) ^ c3 ^ k1;
+            c1 = uint32_t(p1);
+            c3 = uint32_t(p0);
+            c0 = n0;
+            c2 = n2;
+            k0 += 0x9E3779B9;
+            k1 += 0xBB67AE85;
+        }
+        out[0] = c0;
+        out[1] = c1;
+        out[2] = c2;
+        out[3] = c3;
+    }
+
+    const uint32_t *Key() const noexcept { return key; }
+    uint64_t Stream() const noexcept { return nStream; }
+
+private:
+    uint32_t key[2];
+    uint64_t nStream;
+    uint64_t nPosition = 0;
+    uint64_t nBufferCounter = std::numeric_limits<uint64_t>::max();
+    uint64_t buffer[2] = {0, 0};
+};
+
+/**
+ * Fills out with count unit-mean exponential variates, -log(1 - u) for the
+ * next count uniforms of rng (as Philox4x32::Uniform), and advances rng past
+ * them. Whole counters are generated and transformed several at a time with
+ * AVX2 when the CPU supports it; results are bit-identical either way.
+ */
+void SampleExponential(Philox4x32 &rng, double *out, size_t count) noexcept;
+
+/** Name of the sampler kernel selected at load time: "avx2" or "scalar". */
+const char *SampleExponentialKernelName() noexcept;
+
+#endif // ASERTI3_416_RANDOM_HPP_
@@ -0,0 +1,317 @@
+/**
+ * Copyright (c) 2020 Fernando Pelliccioni
+ */
+
+// Vectorized first half of CalculateASERT (see CalculateASERTShiftsAndFactor)
+// for many evaluations sharing the same nPowTargetSpacing and nHalfLife.
+//
+// The exponent division is done in double precision: all the operands are
+// integers below 2^53, so the quotient is corrected back to the exact
+// truncated integer division of the scalar path. Lanes whose inputs fall out
+// of that range are handed to the scalar implementation, so the result is
+// always bit-identical to CalculateASERTShiftsAndFactor().
+//
+// The AVX2 and AVX-512 kernels are compiled with target attributes and
+// selected at load time depending on the running CPU.
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+#include "aserti3-416.hpp"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define ASERT_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// Lane inputs must satisfy |nTimeDiff|, |nHeightDiff| < 2^31 and
+// |nTimeDiff - nPowTargetSpacing * nHeightDiff| < 2^36, so that the
+// fixed-point numerator stays below 2^52.
+constexpr int64_t maxLaneInput = int64_t(1) << 31;
+constexpr double maxLaneDiff = double(int64_t(1) << 36);
+
+// The whole batch goes through the scalar path if the shared parameters
+// would break the exactness of the double arithmetic.
+bool VectorizableParams(int64_t nPowTargetSpacing, int64_t nHalfLife) {
+    return nHalfLife > 0 && nHalfLife < (int64_t(1) << 40) &&
+           nPowTargetSpacing > -(int64_t(1) << 20) && nPowTargetSpacing < (int64_t(1) << 20);
+}
+
+void ShiftsAndFactorsScalar(int64_t nPowTargetSpacing,
+                            int64_t nHalfLife,
+                            const int64_t *nTimeDiffs,
+                            const int64_t *nHeightDiffs,
+                            size_t count,
+                            int64_t *shiftsOut,
+                            uint64_t *factorsOut) noexcept {
+    for (size_t i = 0; i < count; ++i) {
+        CalculateASERTShiftsAndFactor(nPowTargetSpacing, nTimeDiffs[i], nHeightDiffs[i], nHalfLife,
+                                      shiftsOut[i], factorsOut[i]);
+    }
+}
+
+#if defined(ASERT_X86_SIMD)
+
+// 0x4338000000000000: 1.5 * 2^52, used for exact int64 <-> double conversions
+// of values below 2^51 in magnitude.
+constexpr double magic = 6755399441055744.0;
+
+// 195766423245049 split into 32-bit halves, since AVX2 only has 32x32->64
+// multiplications.
+constexpr uint32_t c1Lo = uint32_t(195766423245049ull & 0xffffffff);
+constexpr uint32_t c1Hi = uint32_t(195766423245049ull >> 32);
+constexpr uint32_t c2 = 971821376;
+constexpr uint32_t c3 = 5127;
+
+__attribute__((target("avx2")))
+inline __m256d ToDouble(__m256i x) {
+    const __m256d m = _mm256_set1_pd(magic);
+    return _mm256_sub_pd(_mm256_castsi256_pd(_mm256_add_epi64(x, _mm256_castpd_si256(m))), m);
+}
+
+__attribute__((target("avx2")))
+inline __m256i ToInt64(__m256d x) {
+    const __m256d m = _mm256_set1_pd(magic);
+    return _mm256_sub_epi64(_mm256_castpd_si256(_mm256_add_pd(x, m)), _mm256_castpd_si256(m));
+}
+
+__attribute__((target("avx2")))
+void ShiftsAndFactorsAVX2(int64_t nPowTargetSpacing,
+                          int64_t nHalfLife,
+                          const int64_t *nTimeDiffs,
+                          const int64_t *nHeightDiffs,
+                          size_t count,
+                          int64_t *shiftsOut,
+                          uint64_t *factorsOut) noexcept {
+    size_t i = 0;
+
+    if (VectorizableParams(nPowTargetSpacing, nHalfLife)) {
+        const __m256d spacing = _mm256_set1_pd(double(nPowTargetSpacing));
+        const __m256d halfLife = _mm256_set1_pd(double(nHalfLife));
+        const __m256d radix = _mm256_set1_pd(65536.0);
+        const __m256d invRadix = _mm256_set1_pd(1.0 / 65536.0);
+        const __m256d maxDiff = _mm256_set1_pd(maxLaneDiff);
+        const __m256d zero = _mm256_setzero_pd();
+        const __m256d one = _mm256_set1_pd(1.0);
+        const __m256d signMask = _mm256_set1_pd(-0.0);
+        const __m256i inputBias = _mm256_set1_epi64x(maxLaneInput);
+        const __m256i rounding = _mm256_set1_epi64x(int64_t(1) << 47);
+
+        for (; i + 4 <= count; i += 4) {
+            const __m256i td = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(nTimeDiffs + i));
+            const __m256i hd = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(nHeightDiffs + i));
+
+            // Both inputs in (-2^31, 2^31): x + 2^31 must fit in 32 bits.
+            const __m256i outOfRange = _mm256_or_si256(
+                _mm256_srli_epi64(_mm256_add_epi64(td, inputBias), 32),
+                _mm256_srli_epi64(_mm256_add_epi64(hd, inputBias), 32));
+            if ( ! _mm256_testz_si256(outOfRange, outOfRange)) {
+                ShiftsAndFactorsScalar(nPowTargetSpacing, nHalfLife, nTimeDiffs + i, nHeightDiffs + i, 4,
+                                       shiftsOut + i, factorsOut + i);
+                continue;
+            }
+
+            const __m256d diff = _mm256_sub_pd(ToDouble(td), _mm256_mul_pd(spacing, ToDouble(hd)));
+            if (_mm256_movemask_pd(_mm256_cmp_pd(_mm256_andnot_pd(signMask, diff), maxDiff, _CMP_GE_OQ))) {
+                ShiftsAndFactorsScalar(nPowTargetSpacing, nHalfLife, nTimeDiffs + i, nHeightDiffs + i, 4,
+                                       shiftsOut + i, factorsOut + i);
+                continue;
+            }
+
+            // exponent = (diff << rbits) / nHalfLife, truncated towards zero.
+            const __m256d num = _mm256_mul_pd(diff, radix);
+            __m256d q = _mm256_round_pd(_mm256_div_pd(num, halfLife), _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+            const __m256d rem = _mm256_sub_pd(num, _mm256_mul_pd(q, halfLife));
+            const __m256d numNeg = _mm256_cmp_pd(num, zero, _CMP_LT_OQ);
+            const __m256d tooHigh = _mm256_andnot_pd(numNeg, _mm256_cmp_pd(rem, zero, _CMP_LT_OQ));
+            const __m256d tooLow = _mm256_and_pd(numNeg, _mm256_cmp_pd(rem, zero, _CMP_GT_OQ));
+            q = _mm256_sub_pd(q, _mm256_and_pd(tooHigh, one));
+            q = _mm256_add_pd(q, _mm256_and_pd(tooLow, one));
+
+            // shifts = exponent >> rbits, exponent -= shifts << rbits.
+            const __m256d shifts = _mm256_floor_pd(_mm256_mul_pd(q, invRadix));
+            const __m256d frac = _mm256_sub_pd(q, _mm256_mul_pd(shifts, radix));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(shiftsOut + i), ToInt64(shifts));
+
+            // factor = (c1*x + c2*x^2 + c3*x^3 + 2^47) >> 48, modulo 2^64.
+            const __m256i x = _mm256_cvtepu32_epi64(_mm256_cvttpd_epi32(frac));
+            const __m256i x2 = _mm256_mul_epu32(x, x);
+            const __m256i x3 = _mm256_mul_epu32(x2, x);
+            const __m256i t1 = _mm256_add_epi64(
+                _mm256_mul_epu32(x, _mm256_set1_epi64x(c1Lo)),
+                _mm256_slli_epi64(_mm256_mul_epu32(x, _mm256_set1_epi64x(c1Hi)), 32));
+            const __m256i t2 = _mm256_mul_epu32(x2, _mm256_set1_epi64x(c2));
+            const __m256i t3 = _mm256_add_epi64(
+                _mm256_mul_epu32(x3, _mm256_set1_epi64x(c3)),
+                _mm256_slli_epi64(_mm256_mul_epu32(_mm256_srli_epi64(x3, 32), _mm256_set1_epi64x(c3)), 32));
+            const __m256i sum = _mm256_add_epi64(_mm256_add_epi64(t1, t2), _mm256_add_epi64(t3, rounding));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(factorsOut + i), _mm256_srli_epi64(sum, 48));
+        }
+    }
+
+    ShiftsAndFactorsScalar(nPowTargetSpacing, nHalfLife, nTimeDiffs + i, nHeightDiffs + i, count - i,
+                           shiftsOut + i, factorsOut + i);
+}
+
+__attribute__((target("avx512f")))
+inline __m512d ToDouble(__m512i x) {
+    const __m512d m = _mm512_set1_pd(magic);
+    return _mm512_sub_pd(_mm512_castsi512_pd(_mm512_add_epi64(x, _mm512_castpd_si512(m))), m);
+}
+
+__attribute__((target("avx512f")))
+inline __m512i ToInt64(__m512d x) {
+    const __m512d m = _mm512_set1_pd(magic);
+    return _mm512_sub_epi64(_mm512_castpd_si512(_mm512_add_pd(x, m)), _mm512_castpd_si512(m));
+}
+
+// GCC 12's avx512fintrin.h expands most unmasked intrinsics with an
+// _mm512_undefined_*() merge source, which -Wmaybe-uninitialized then
+// reports once inlined here. A false positive of the header.
+#if defined(__GNUC__) && ! defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+__attribute__((target("avx512f")))
+void ShiftsAndFactorsAVX512(int64_t nPowTargetSpacing,
+                            int64_t nHalfLife,
+                            const int64_t *nTimeDiffs,
+                            const int64_t *nHeightDiffs,
+                            size_t count,
+                            int64_t *shiftsOut,
+                            uint64_t *factorsOut) noexcept {
+    size_t i = 0;
+
+    if (VectorizableParams(nPowTargetSpacing, nHalfLife)) {
+        const __m512d spacing = _mm512_set1_pd(double(nPowTargetSpacing));
+        const __m512d halfLife = _mm512_set1_pd(double(nHalfLife));
+        const __m512d radix = _mm512_set1_pd(65536.0);
+        const __m512d invRadix = _mm512_set1_pd(1.0 / 65536.0);
+        const __m512d maxDiff = _mm512_set1_pd(maxLaneDiff);
+        const __m512d zero = _mm512_setzero_pd();
+        const __m512d one = _mm512_set1_pd(1.0);
+        const __m512i inputBias = _mm512_set1_epi64(maxLaneInput);
+        const __m512i rounding = _mm512_set1_epi64(int64_t(1) << 47);
+
+        for (; i + 8 <= count; i += 8) {
+            const __m512i td = _mm512_loadu_si512(nTimeDiffs + i);
+            const __m512i hd = _mm512_loadu_si512(nHeightDiffs + i);
+
+            const __m512i outOfRange = _mm512_or_si512(
+                _mm512_srli_epi64(_mm512_add_epi64(td, inputBias), 32),
+                _mm512_srli_epi64(_mm512_add_epi64(hd, inputBias), 32));
+            if (_mm512_test_epi64_mask(outOfRange, outOfRange)) {
+                ShiftsAndFactorsScalar(nPowTargetSpacing, nHalfLife, nTimeDiffs + i, nHeightDiffs + i, 8,
+                                       shiftsOut + i, factorsOut + i);
+                continue;
+            }
+
+            const __m512d diff = _mm512_sub_pd(ToDouble(td), _mm512_mul_pd(spacing, ToDouble(hd)));
+            if (_mm512_cmp_pd_mask(_mm512_abs_pd(diff), maxDiff, _CMP_GE_OQ)) {
+                ShiftsAndFactorsScalar(nPowTargetSpacing, nHalfLife, nTimeDiffs + i, nHeightDiffs + i, 8,
+                                       shiftsOut + i, factorsOut + i);
+                continue;
+            }
+
+            const __m512d num = _mm512_mul_pd(diff, radix);
+            __m512d q = _mm512_roundscale_pd(_mm512_div_pd(num, halfLife), _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+            const __m512d rem = _mm512_sub_pd(num, _mm512_mul_pd(q, halfLife));
+            const __mmask8 numNeg = _mm512_cmp_pd_mask(num, zero, _CMP_LT_OQ);
+            const __mmask8 tooHigh = _mm512_mask_cmp_pd_mask(__mmask8(~numNeg), rem, zero, _CMP_LT_OQ);
+            const __mmask8 tooLow = _mm512_mask_cmp_pd_mask(numNeg, rem, zero, _CMP_GT_OQ);
+            q = _mm512_mask_sub_pd(q, tooHigh, q, one);
+            q = _mm512_mask_add_pd(q, tooLow, q, one);
+
+            const __m512d shifts = _mm512_roundscale_pd(_mm512_mul_pd(q, invRadix), _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+            const __m512d frac = _mm512_sub_pd(q, _mm512_mul_pd(shifts, radix));
+            _mm512_storeu_si512(shiftsOut + i, ToInt64(shifts));
+
+            const __m512i x = _mm512_cvtepu32_epi64(_mm512_cvttpd_epi32(frac));
+            const __m512i x2 = _mm512_mul_epu32(x, x);
+            const __m512i x3 = _mm512_mul_epu32(x2, x);
+            const __m512i t1 = _mm512_add_epi64(
+                _mm512_mul_epu32(x, _mm512_set1_epi64(c1Lo)),
+                _mm512_slli_epi64(_mm512_mul_epu32(x, _mm512_set1_epi64(c1Hi)), 32));
+            const __m512i t2 = _mm512_mul_epu32(x2, _mm512_set1_epi64(c2));
+            const __m512i t3 = _mm512_add_epi64(
+                _mm512_mul_epu32(x3, _mm512_set1_epi64(c3)),
+                _mm512_slli_epi64(_mm512_mul_epu32(_mm512_srli_epi64(x3, 32), _mm512_set1_epi64(c3)), 32));
+            const __m512i sum = _mm512_add_epi64(_mm512_add_epi64(t1, t2), _mm512_add_epi64(t3, rounding));
+            _mm512_storeu_si512(factorsOut + i, _mm512_srli_epi64(sum, 48));
+        }
+    }
+
+    ShiftsAndFactorsScalar(nPowTargetSpacing, nHalfLife, nTimeDiffs + i, nHeightDiffs + i, count - i,
+                           shiftsOut + i, factorsOut + i);
+}
+
+#if defined(__GNUC__) && ! defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#endif // defined(ASERT_X86_SIMD)
+
+using ShiftsAndFactorsFn = void (*)(int64_t, int64_t, const int64_t *, const int64_t *, size_t,
+                                    int64_t *, uint64_t *) noexcept;
+
+struct Kernel {
+    ShiftsAndFactorsFn fn;
+    const char *name;
+};
+
+// The kernels of this build the running CPU supports, best first.
+std::vector<Kernel> SupportedKernels() {
+    std::vector<Kernel> kernels;
+#if defined(ASERT_X86_SIMD)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        kernels.push_back({ShiftsAndFactorsAVX512, "avx512"});
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        kernels.push_back({ShiftsAndFactorsAVX2, "avx2"});
+    }
+#endif
+    kernels.push_back({ShiftsAndFactorsScalar, "scalar"});
+    return kernels;
+}
+
+// Resolved once at load time, no per-call dispatch cost.
+const Kernel kernel = SupportedKernels().front();
+
+} // namespace
+
+void CalculateASERTShiftsAndFactors(const int64_t nPowTargetSpacing,
+                                    const int64_t nHalfLife,
+                                    const int64_t *nTimeDiffs,
+                                    const int64_t *nHeightDiffs,
+                                    size_t count,
+                                    int64_t *shiftsOut,
+                                    uint64_t *factorsOut) noexcept {
+    kernel.fn(nPowTargetSpacing, nHalfLife, nTimeDiffs, nHeightDiffs, count, shiftsOut, factorsOut);
+}
+
+const char *ASERTKernelName() noexcept {
+    return kernel.name;
+}
+
+bool CalculateASERTShiftsAndFactorsOn(const char *kernelName,
+                                      const int64_t nPowTargetSpacing,
+                                      const int64_t nHalfLife,
+                                      const int64_t *nTimeDiffs,
+                                      const int64_t *nHeightDiffs,
+                                      size_t count,
+                                      int64_t *shiftsOut,
+                                      uint64_t *factorsOut) {
+    for (const Kernel &k : SupportedKernels()) {
+        if (std::strcmp(k.name, kernelName) == 0) {
+            k.fn(nPowTargetSpacing, nHalfLife, nTimeDiffs, nHeightDiffs, count, shiftsOut, factorsOut);
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,472 @@
+/**
+ * Copyright (c) 2020 Fernando Pelliccioni
+ */
+
+// Native version of the mining.py Monte-Carlo simulation, see
+// aserti3-416_simul.hpp.
+//
+// Each run keeps its chain in two flat arrays (timestamps and revenue
+// ratios, the only per-block history the model reads back) and derives the
+// next target from an ASERTContext of the reference block, so a run does no
+// allocation nor big integer work per block besides the ASERT step itself.
+// The other registered algorithms read a CChainStore of the run instead.
+//
+// Run i of a seed draws from two Philox4x32 streams of that seed: 2i for the
+// block time exponentials, all sampled upfront in one batch, and 2i + 1 for
+// everything else.
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <optional>
+#include <thread>
+
+#include "aserti3-416_random.hpp"
+#include "aserti3-416_simul.hpp"
+
+namespace {
+
+// Steady blocks before the simulated ones, as in run_one_simul.
+constexpr int nPrefixBlocks = 2020;
+
+double CompactToDouble(uint32_t nBits) {
+    const int nSize = nBits >> 24;
+    const uint32_t nWord = nBits & 0x007fffff;
+    if (nSize <= 3) {
+        return double(nWord >> (8 * (3 - nSize)));
+    }
+    return std::ldexp(double(nWord), 8 * (nSize - 3));
+}
+
+// suitable_block_index(i): median by timestamp of blocks i - 2, i - 1 and i.
+size_t SuitableIndex(const int64_t *timestamps, size_t i) {
+    size_t indices[3] = {i - 2, i - 1, i};
+    if (timestamps[indices[0]] > timestamps[indices[2]]) {
+        std::swap(indices[0], indices[2]);
+    }
+    if (timestamps[indices[0]] > timestamps[indices[1]]) {
+        std::swap(indices[0], indices[1]);
+    }
+    if (timestamps[indices[1]] > timestamps[indices[2]]) {
+        std::swap(indices[1], indices[2]);
+    }
+    return indices[1];
+}
+
+// median_time_past(states[-11:])
+int64_t MedianTimePast(const int64_t *timestamps, size_t size) {
+    int64_t times[11];
+    const size_t n = std::min<size_t>(size, 11);
+    std::copy(timestamps + size - n, timestamps + size, times);
+    std::nth_element(times, times + n / 2, times + n);
+    return times[n / 2];
+}
+
+SimulRunStats BlockTimeStats(const int64_t *timestamps, size_t count) {
+    SimulRunStats stats {0, 0, 0, 0};
+    if (count < 2) {
+        return stats;
+    }
+
+    std::vector<int64_t> blockTimes(count - 1);
+    int64_t nSum = 0;
+    int64_t nMax = timestamps[1] - timestamps[0];
+    for (size_t i = 0; i < count - 1; ++i) {
+        blockTimes[i] = timestamps[i + 1] - timestamps[i];
+        nSum += blockTimes[i];
+        nMax = std::max(nMax, blockTimes[i]);
+    }
+    const size_t n = blockTimes.size();
+    stats.mean = double(nSum) / n;
+    stats.max = double(nMax);
+
+    if (n > 1) {
+        double sumSquares = 0;
+        for (const int64_t blockTime : blockTimes) {
+            sumSquares += (blockTime - stats.mean) * (blockTime - stats.mean);
+        }
+        stats.stdev = std::sqrt(sumSquares / (n - 1));
+    }
+
+    std::nth_element(blockTimes.begin(), blockTimes.begin() + n / 2, blockTimes.end());
+    stats.median = double(blockTimes[n / 2]);
+    return stats;
+}
+
+SimulStat Summarize(std::vector<double> values) {
+    SimulStat stat {0, 0, 0, 0, 0};
+    if (values.empty()) {
+        return stat;
+    }
+    const size_t n = values.size();
+
+    double sum = 0;
+    for (const double value : values) {
+        sum += value;
+    }
+    stat.mean = sum / n;
+    if (n > 1) {
+        double sumSquares = 0;
+        for (const double value : values) {
+            sumSquares += (value - stat.mean) * (value - stat.mean);
+        }
+        stat.stdev = std::sqrt(sumSquares / (n - 1));
+    }
+
+    std::sort(values.begin(), values.end());
+    stat.min = values.front();
+    stat.max = values.back();
+    stat.median = values[n / 2];
+    return stat;
+}
+
+} // namespace
+
+bool SetSimulParam(SimulParams &simul, const std::string &name, double value) {
+    if (name == "INITIAL_BCC_BITS") {
+        simul.nInitialBCCBits = uint32_t(value);
+    } else if (name == "INITIAL_SWC_BITS") {
+        simul.nInitialSWCBits = uint32_t(value);
+    } else if (name == "INITIAL_FX") {
+        simul.initialFX = value;
+    } else if (name == "INITIAL_TIMESTAMP") {
+        simul.nInitialTimestamp = int64_t(value);
+    } else if (name == "INITIAL_HEIGHT") {
+        simul.nInitialHeight = int(value);
+    } else if (name == "BTC_fees") {
+        simul.btcFees = value;
+    } else if (name == "BCH_fees") {
+        simul.bchFees = value;
+    } else if (name == "num_blocks") {
+        simul.nBlocks = int(value);
+    } else if (name == "STEADY_HASHRATE") {
+        simul.steadyHashrate = value;
+    } else if (name == "VARIABLE_HASHRATE") {
+        simul.variableHashrate = value;
+    } else if (name == "VARIABLE_PCT") {
+        simul.variablePct = value;
+    } else if (name == "VARIABLE_WINDOW") {
+        simul.nVariableWindow = int(value);
+    } else if (name == "VARIABLE_EXPONENT") {
+        simul.variableExponent = value;
+    } else if (name == "MEMORY_GAIN") {
+        simul.memoryGain = value;
+    } else if (name == "GREEDY_HASHRATE") {
+        simul.greedyHashrate = value;
+    } else if (name == "GREEDY_PCT") {
+        simul.greedyPct = value;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool GetSimulScenario(const std::string &name, SimulScenario &scenario) {
+    using FX = SimulScenario::FX;
+    using FXJumps = SimulScenario::FXJumps;
+
+    if (name == "default") {
+        scenario = {FX::Random, FXJumps::Small, 0, 0};
+    } else if (name == "stable") {
+        scenario = {FX::Constant, FXJumps::None, 0, 0};
+    } else if (name == "fxramp") {
+        scenario = {FX::Ramp, FXJumps::Small, 0, 0};
+    } else if (name == "dr50") {
+        scenario = {FX::Random, FXJumps::Small, 50, 0};
+    } else if (name == "dr75") {
+        scenario = {FX::Random, FXJumps::Small, 75, 0};
+    } else if (name == "dr100") {
+        scenario = {FX::Random, FXJumps::Small, 100, 0};
+    } else if (name == "pump-osc") {
+        scenario = {FX::Ramp, FXJumps::Small, 0, 8000};
+    } else if (name == "ft50") {
+        scenario = {FX::Random, FXJumps::Small, -50, 0};
+    } else if (name == "ft100") {
+        scenario = {FX::Random, FXJumps::Small, -100, 0};
+    } else if (name == "price10x") {
+        scenario = {FX::Random, FXJumps::Large, 0, 0};
+    } else {
+        return false;
+    }
+    return true;
+}
+
+namespace {
+
+// Targets of an ASERT variant of order nOrder: the block loop calls its
+// CalculateASERTi instantiation directly.
+template <int nOrder>
+class ASERTiNextTarget {
+public:
+    ASERTiNextTarget(const ASERTiVariant &variant, const Consensus::Params &params)
+        : variant(variant)
+        , params(params)
+    {
+        if (variant.nHalfLife != 0) {
+            this->params.nDAAHalfLife = variant.nHalfLife;
+        }
+    }
+
+    // Mo3 takes the suitable block of index 2 as its reference block, as
+    // next_bits_aserti_416_cpp does.
+    void Start(const std::vector<int64_t> &timestamps, int nFirstHeight, uint32_t nBits) {
+        this->nFirstHeight = nFirstHeight;
+        nRefIndex = variant.fMedianOfThree ? SuitableIndex(timestamps.data(), 2) : 0;
+        asert.emplace(nFirstHeight + int(nRefIndex), timestamps[nRefIndex], nBits, params);
+    }
+
+    uint32_t operator()(const std::vector<int64_t> &timestamps) const {
+        size_t nLastIndex = timestamps.size() - 1;
+        if (variant.fMedianOfThree) {
+            nLastIndex = SuitableIndex(timestamps.data(), nLastIndex);
+            if (nLastIndex <= nRefIndex) {
+                return asert->nRefBits;
+            }
+        }
+        return asert->template next<nOrder, 16>(timestamps[nLastIndex], nFirstHeight + int(nLastIndex));
+    }
+
+    void Push(int64_t, uint32_t) {}
+
+private:
+    ASERTiVariant variant;
+    Consensus::Params params;
+    int nFirstHeight = 0;
+    size_t nRefIndex = 0;
+    std::optional<ASERTContext> asert;
+};
+
+// Targets of any other registered algorithm, from a chain store of the run.
+class DAANextTarget {
+public:
+    DAANextTarget(const DifficultyAlgorithm &algo, const Consensus::Params &params)
+        : algo(algo)
+        , params(params)
+    {}
+
+    void Start(const std::vector<int64_t> &timestamps, int nFirstHeight, uint32_t nBits) {
+        chain = CChainStore(nFirstHeight, algo.NeedsChainWork());
+        for (const int64_t nTime : timestamps) {
+            chain.push_back(uint32_t(nTime), nBits);
+        }
+    }
+
+    uint32_t operator()(const std::vector<int64_t> &) const {
+        return algo.GetNextWorkRequired(chain, chain.TipHeight(), params);
+    }
+
+    void Push(int64_t nTime, uint32_t nBits) {
+        chain.push_back(uint32_t(nTime), nBits);
+    }
+
+private:
+    const DifficultyAlgorithm &algo;
+    const Consensus::Params &params;
+    CChainStore chain;
+};
+
+template <typename NextTarget>
+SimulRunStats RunSimulationWith(const SimulParams &simul,
+                                const SimulScenario &scenario,
+                                const Consensus::Params &params,
+                                uint64_t seed,
+                                uint64_t nRun,
+                                NextTarget nextTarget) {
+    assert(simul.nBlocks > 0);
+    assert(simul.nVariableWindow > 0 && simul.nVariableWindow <= nPrefixBlocks);
+
+    Philox4x32 rng(seed, 2 * nRun + 1);
+    std::vector<double> exponentials(simul.nBlocks);
+    {
+        Philox4x32 blockTimeRng(seed, 2 * nRun);
+        SampleExponential(blockTimeRng, exponentials.data(), exponentials.size());
+    }
+
+    const int64_t nSpacing = params.nPowTargetSpacing;
+    const size_t nTotal = size_t(nPrefixBlocks) + simul.nBlocks;
+
+    std::vector<int64_t> timestamps;
+    std::vector<double> revRatios;
+    timestamps.reserve(nTotal);
+    revRatios.reserve(nTotal);
+
+    // Initial state is after 2020 steady prefix blocks.
+    for (int n = -nPrefixBlocks; n < 0; ++n) {
+        timestamps.push_back(simul.nInitialTimestamp + n * nSpacing);
+        revRatios.push_back(0.0);
+    }
+    int64_t nWallTime = timestamps.back();
+    double fx = simul.initialFX;
+    double memoryFrac = 0.0;
+    double greedyFrac = 0.0;
+
+    // Heights are simul.nInitialHeight - nPrefixBlocks + index.
+    nextTarget.Start(timestamps, simul.nInitialHeight - nPrefixBlocks, simul.nInitialBCCBits);
+    const double swcTarget = CompactToDouble(simul.nInitialSWCBits);
+
+    // A few randomly-timed FX jumps to see how the algorithm recalibrates.
+    // The factor is drawn before the block, as in Python's
+    // fx_jumps[randrange(...)] = choice(...).
+    std::vector<double> fxJumps(simul.nBlocks, 1.0);
+    if (scenario.fxJumps == SimulScenario::FXJumps::Large) {
+        static const double factorChoices[] = {0.1, 0.25, 0.5, 2.0, 4.0, 10.0};
+        for (int n = 0; n < 4; ++n) {
+            const double factor = factorChoices[rng.Below(6)];
+            fxJumps[rng.Below(simul.nBlocks)] = factor;
+        }
+    } else if (scenario.fxJumps == SimulScenario::FXJumps::Small) {
+        static const double factorChoices[] = {0.85, 0.9, 1.1, 1.15};
+        for (int n = 0; n < 10; ++n) {
+            const double factor = factorChoices[rng.Below(4)];
+            fxJumps[rng.Below(simul.nBlocks)] = factor;
+        }
+    }
+
+    const double high = 1.0 + simul.variablePct / 100;
+    const double scaleFac = 50 / simul.variablePct;
+    const int N = simul.nVariableWindow;
+
+    for (int n = 0; n < simul.nBlocks; ++n) {
+        const size_t size = timestamps.size();
+
+        // next_hashrate
+        double sumRevRatio = 0;
+        for (size_t i = size - N; i < size; ++i) {
+            sumRevRatio += revRatios[i];
+        }
+        const double meanRevRatio = sumRevRatio / N;
+
+        double varFrac = (high - std::pow(meanRevRatio, simul.variableExponent)) * scaleFac;
+        memoryFrac = memoryFrac + (varFrac - .5) * simul.memoryGain;
+        varFrac = std::max(0.0, std::min(1.0, varFrac + memoryFrac));
+
+        if (scenario.nPump144Threshold > 0 &&
+            timestamps[size - 1 - 144 + 5] - timestamps[size - 1 - 144] > scenario.nPump144Threshold) {
+            varFrac = std::max(varFrac, .25);
+        }
+
+        if (meanRevRatio >= 1 + simul.greedyPct / 100) {
+            greedyFrac = 0.0;
+        } else if (meanRevRatio <= 1 - simul.greedyPct / 100) {
+            greedyFrac = 1.0;
+        }
+
+        const double hashrate = simul.steadyHashrate + scenario.drHashrate
+                              + simul.variableHashrate * varFrac
+                              + simul.greedyHashrate * greedyFrac;
+
+        // next_step
+        const uint32_t nBits = nextTarget(timestamps);
+        const double target = CompactToDouble(nBits);
+
+        // See how long we take to mine a block: scale a unit exponential.
+        const double meanHashes = std::ldexp(1.0, 256) / target;
+        const double meanTime = meanHashes / (hashrate * 1e15);
+        nWallTime += int64_t(exponentials[n] * meanTime + 0.5);
+
+        // Did the difficulty ramp hashrate get the block?
+        int64_t nTimestamp = nWallTime;
+        if (rng.Uniform() < std::abs(scenario.drHashrate) / hashrate) {
+            if (scenario.drHashrate > 0) {
+                nTimestamp = MedianTimePast(timestamps.data(), size) + 1;
+            } else {
+                nTimestamp = nWallTime + 2 * 60 * 60;
+            }
+        }
+
+        // Get a new FX rate.
+        const double r = rng.Uniform();
+        switch (scenario.fx) {
+        case SimulScenario::FX::Random:
+            fx = fx * (1.0 + (r - 0.5) / 200);
+            break;
+        case SimulScenario::FX::Constant:
+            break;
+        case SimulScenario::FX::Ramp:
+            fx = fx * 1.00017149454;
+            break;
+        }
+        fx *= fxJumps[n];
+
+        // revenue_ratio
+        const double swcRevenue = 12.5 + simul.btcFees * rng.Uniform();
+        const double bccRevenue = (12.5 + simul.bchFees * rng.Uniform()) * fx;
+        const double swcDifficultyRatio = target / swcTarget;
+
+        timestamps.push_back(nTimestamp);
+        revRatios.push_back(swcRevenue / swcDifficultyRatio / bccRevenue);
+        nextTarget.Push(nTimestamp, nBits);
+    }
+
+    // Drop the prefix blocks to be left with the simulation blocks.
+    return BlockTimeStats(timestamps.data() + nPrefixBlocks, simul.nBlocks);
+}
+
+} // namespace
+
+SimulRunStats RunSimulation(const SimulParams &simul,
+                            const SimulScenario &scenario,
+                            const Consensus::Params &params,
+                            uint64_t seed,
+                            uint64_t nRun) {
+    assert(simul.algo != nullptr);
+    const ASERTiVariant *variant = simul.algo->GetASERTiVariant();
+    if (variant == nullptr) {
+        return RunSimulationWith(simul, scenario, params, seed, nRun, DAANextTarget(*simul.algo, params));
+    }
+    switch (variant->nOrder) {
+    case 1:
+        return RunSimulationWith(simul, scenario, params, seed, nRun, ASERTiNextTarget<1>(*variant, params));
+    case 2:
+        return RunSimulationWith(simul, scenario, params, seed, nRun, ASERTiNextTarget<2>(*variant, params));
+    default:
+        assert(variant->nOrder == 3);
+        return RunSimulationWith(simul, scenario, params, seed, nRun, ASERTiNextTarget<3>(*variant, params));
+    }
+}
+
+std::vector<SimulRunStats> RunSimulations(const SimulParams &simul,
+                                          const SimulScenario &scenario,
+                                          const Consensus::Params &params,
+                                          uint64_t seed,
+                                          size_t count,
+                                          unsigned int nThreads) {
+    std::vector<SimulRunStats> runs(count);
+
+    if (nThreads == 0) {
+        nThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    nThreads = unsigned(std::min<size_t>(nThreads, count));
+
+    // Runs are handed out one at a time: their cost varies with the scenario
+    // and the random draws.
+    std::atomic<size_t> next {0};
+    auto worker = [&]() {
+        for (size_t i = next++; i < count; i = next++) {
+            runs[i] = RunSimulation(simul, scenario, params, seed, i);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned int i = 1; i < nThreads; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    return runs;
+}
+
+SimulSummary SummarizeSimulations(const std::vector<SimulRunStats> &runs) {
+    std::vector<double> means, stdevs, medians, maxs;
+    for (const auto &run : runs) {
+        means.push_back(run.mean);
+        stdevs.push_back(run.stdev);
+        medians.push_back(run.median);
+        maxs.push_back(run.max);
+    }
+    return {Summarize(std::move(means)), Summarize(std::move(stdevs)),
+            Summarize(std::move(medians)), Summarize(std::move(maxs))};
+}
@@ -0,0 +1,114 @@
+#ifndef ASERTI3_416_SIMUL_HPP_
+#define ASERTI3_416_SIMUL_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "aserti3-416.hpp"
+#include "aserti3-416_daa.hpp"
+
+/**
+ * Native port of the mining.py simulation (run_one_simul / next_step /
+ * next_hashrate) for the registered difficulty algorithms: steady, variable and
+ * greedy miners switching between two chains by relative revenue, FX jumps,
+ * difficulty rampers and future timestamps.
+ * Defaults are the ones in mining.py's default_params, VARIABLE_EXPONENT as
+ * used by dashdiffsim.py.
+ */
+struct SimulParams {
+    uint32_t nInitialBCCBits = 0x18084bb7;
+    uint32_t nInitialSWCBits = 0x18013ce9;
+    double initialFX = 0.19;
+    int64_t nInitialTimestamp = 1503430225;
+    int nInitialHeight = 481824;
+    double btcFees = 0.02;
+    double bchFees = 0.002;
+    int nBlocks = 10000;
+
+    // In PH/s.
+    double steadyHashrate = 300;
+    double variableHashrate = 2000;
+    double variablePct = 15;
+    int nVariableWindow = 6;
+    double variableExponent = .5;
+    double memoryGain = .01;
+    double greedyHashrate = 2000;
+    double greedyPct = 10;
+
+    const DifficultyAlgorithm *algo = GetDifficultyAlgorithm("aserti3-416-cpp");
+};
+
+/**
+ * Sets the field named as the corresponding mining.py params key
+ * (e.g. "INITIAL_BCC_BITS"). Returns false if the name is unknown.
+ */
+bool SetSimulParam(SimulParams &simul, const std::string &name, double value);
+
+/** One entry of mining.py's Scenarios. */
+struct SimulScenario {
+    enum class FX { Random, Constant, Ramp };
+    // Small: 10 jumps of 0.85-1.15, None: "price1x", Large: "price10x".
+    enum class FXJumps { Small, None, Large };
+
+    FX fx;
+    FXJumps fxJumps;
+    double drHashrate;
+    int64_t nPump144Threshold;
+};
+
+/** Looks up a scenario by its mining.py name. Returns false if unknown. */
+bool GetSimulScenario(const std::string &name, SimulScenario &scenario);
+
+/** Block time statistics (seconds) of a single run. */
+struct SimulRunStats {
+    double mean;
+    double stdev;
+    double median;
+    double max;
+};
+
+/**
+ * Run nRun of seed: 2020 steady prefix blocks followed by simul.nBlocks
+ * simulated ones, with the prefix's first block as the ASERT reference block.
+ * Randomness comes from Philox4x32 streams keyed by (seed, nRun), so the
+ * result only depends on the arguments.
+ */
+SimulRunStats RunSimulation(const SimulParams &simul,
+                            const SimulScenario &scenario,
+                            const Consensus::Params &params,
+                            uint64_t seed,
+                            uint64_t nRun);
+
+/**
+ * Runs 0 to count - 1 of seed on nThreads worker threads (0: one per
+ * hardware thread). Results are in run order and bit-identical whatever
+ * nThreads is.
+ */
+std::vector<SimulRunStats> RunSimulations(const SimulParams &simul,
+                                          const SimulScenario &scenario,
+                                          const Consensus::Params &params,
+                                          uint64_t seed,
+                                          size_t count,
+                                          unsigned int nThreads);
+
+/** Distribution of one SimulRunStats field across runs. */
+struct SimulStat {
+    double min;
+    double max;
+    double mean;
+    double stdev;
+    double median;
+};
+
+struct SimulSummary {
+    SimulStat mean;
+    SimulStat stdev;
+    SimulStat median;
+    SimulStat max;
+};
+
+SimulSummary SummarizeSimulations(const std::vector<SimulRunStats> &runs);
+
+#endif // ASERTI3_416_SIMUL_HPP_
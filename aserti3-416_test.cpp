@@ -0,0 +1,966 @@
+// g++ -O2 -std=c++17 -pthread aserti3-416_test.cpp aserti3-416.cpp aserti3-416_simd.cpp aserti3-416_random.cpp aserti3-416_daa.cpp aserti3-416_simul.cpp aserti3-416_validation.cpp aserti3-416_pow.cpp aserti3-416_chainwork.cpp aserti3-416_headers.cpp -o aserti3-416_test
+
+/**
+ * Copyright (c) 2020 Fernando Pelliccioni
+ */
+
+// Unit tests. Outputs are checked against reference values computed
+// independently (exact integer arithmetic in Python, published test vectors)
+// or against a plain implementation of the same function. Prints every failed
+// check and exits with a non-zero status if there is any.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "aserti3-416.hpp"
+#include "aserti3-416_daa.hpp"
+#include "aserti3-416_headers.hpp"
+#include "aserti3-416_pow.hpp"
+#include "aserti3-416_random.hpp"
+#include "aserti3-416_simul.hpp"
+#include "aserti3-416_validation.hpp"
+
+namespace {
+
+int nChecks = 0;
+int nFailures = 0;
+
+void Check(bool ok, char const* expr, char const* file, int line) {
+    ++nChecks;
+    if ( ! ok) {
+        ++nFailures;
+        std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expr);
+    }
+}
+
+#define CHECK(expr) Check((expr), #expr, __FILE__, __LINE__)
+
+arith_uint256 FromHex(char const* hex) {
+    return UintToArith256(uint256S(hex));
+}
+
+Consensus::Params MainnetParams() {
+    Consensus::Params params;
+    params.powLimit = uint256S("00000000ffffffffffffffffffffffffffffffffffffffffffffffffffffffff");
+    params.nPowTargetTimespan = 14 * 24 * 60 * 60;
+    params.nPowTargetSpacing = 10 * 60;
+    params.fPowAllowMinDifficultyBlocks = false;
+    params.nDAAHalfLife = 2 * 24 * 60 * 60;
+    return params;
+}
+
+// Bitcoin Core's arith_uint256 SetCompact/GetCompact vectors.
+void TestCompact() {
+    struct Case {
+        uint32_t nCompact;
+        char const* target;
+        bool fNegative;
+        bool fOverflow;
+        uint32_t nRoundTrip;
+    };
+    Case const cases[] = {
+        {0x00000000, "0", false, false, 0x00000000},
+        {0x00123456, "0", false, false, 0x00000000},
+        {0x01003456, "0", false, false, 0x00000000},
+        {0x02000056, "0", false, false, 0x00000000},
+        {0x03000000, "0", false, false, 0x00000000},
+        {0x04000000, "0", false, false, 0x00000000},
+        {0x00923456, "0", false, false, 0x00000000},
+        {0x01803456, "0", false, false, 0x00000000},
+        {0x02800056, "0", false, false, 0x00000000},
+        {0x03800000, "0", false, false, 0x00000000},
+        {0x04800000, "0", false, false, 0x00000000},
+        {0x01123456, "12", false, false, 0x01120000},
+        {0x02123456, "1234", false, false, 0x02123400},
+        {0x03123456, "123456", false, false, 0x03123456},
+        {0x04123456, "12345600", false, false, 0x04123456},
+        {0x05009234, "92340000", false, false, 0x05009234},
+        {0x20123456, "1234560000000000000000000000000000000000000000000000000000000000", false, false, 0x20123456},
+        {0x04923456, "12345600", true, false, 0x04123456},
+        {0x1d00ffff, "00000000ffff0000000000000000000000000000000000000000000000000000", false, false, 0x1d00ffff},
+    };
+    for (auto const& c : cases) {
+        bool fNegative;
+        bool fOverflow;
+        arith_uint256 const target = arith_uint256().SetCompact(c.nCompact, &fNegative, &fOverflow);
+        CHECK(target == FromHex(c.target));
+        CHECK(fNegative == c.fNegative);
+        CHECK(fOverflow == c.fOverflow);
+        CHECK(target.GetCompact() == c.nRoundTrip);
+    }
+
+    bool fOverflow;
+    arith_uint256().SetCompact(0xff123456, nullptr, &fOverflow);
+    CHECK(fOverflow);
+}
+
+// MulU64ShiftRight against Python integers, where the product is truncated
+// to 256 bits before the shift, and against the full 256-bit multiply for
+// random operands and every shift.
+void TestMulU64ShiftRight() {
+    struct Case {
+        char const* x;
+        uint64_t factor;
+        unsigned int shift;
+        char const* result;
+    };
+    Case const cases[] = {
+        {"d76d4330f1446beab0c11fdecb91ce375bc8fbbcbde5c0994164d8399f767c45", 0xa6eb8c9ebd69fe29ull, 16, "00002ca93a6a7cee25190e526dcdc188de5abbc93232dfd05a8aca7a1d600293"},
+        {"00000000000000f1c6a5387777330bdbd7210dff076ce2ef87b0b125ec1d7da0", 0xffffffffffffffffull, 0, "c6a5387777330aea107bd5879039d713b08fa326e4b09ab0784f4eda13e28260"},
+        {"7814e8a25f2dd97f1cfb10f62827688de6a16a3b0d464138a62332553fc1ea36", 0x000000000001bca4ull, 70, "000000000000000000c37a9461fa5f2ec809072d584a545b9ece99e369688021"},
+        {"ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff", 0xffffffffffffffffull, 255, "0000000000000000000000000000000000000000000000000000000000000001"},
+    };
+    for (auto const& c : cases) {
+        arith_uint256 x = FromHex(c.x);
+        CHECK((x * arith_uint256(c.factor)) >> c.shift == FromHex(c.result));
+        x.MulU64ShiftRight(c.factor, c.shift);
+        CHECK(x == FromHex(c.result));
+    }
+
+    std::mt19937_64 rng(5);
+    size_t nMismatches = 0;
+    for (unsigned int shift = 0; shift < 260; ++shift) {
+        arith_uint256 x;
+        for (int i = 0; i < 4; ++i) {
+            x = (x << 64) + arith_uint256(rng());
+        }
+        uint64_t const factor = shift % 3 == 0 ? rng() % 131072 : rng();
+        arith_uint256 result = x;
+        result.MulU64ShiftRight(factor, shift);
+        nMismatches += result != (x * arith_uint256(factor)) >> shift;
+    }
+    CHECK(nMismatches == 0);
+}
+
+// The bit-at-a-time shift and subtract division operator/= used to be.
+arith_uint256 DivideShiftSubtract(arith_uint256 num, arith_uint256 const& div) {
+    arith_uint256 quotient;
+    if (div.bits() > num.bits()) {
+        return quotient;
+    }
+    int shift = int(num.bits() - div.bits());
+    arith_uint256 shifted = div << unsigned(shift);
+    for (; shift >= 0; --shift) {
+        if (num >= shifted) {
+            num -= shifted;
+            quotient += arith_uint256(1) << unsigned(shift);
+        }
+        shifted >>= 1;
+    }
+    return quotient;
+}
+
+// operator/= against Python integer division and the shift and subtract
+// division, on operands of every length.
+void TestDivision() {
+    struct Case {
+        char const* x;
+        char const* y;
+        char const* quotient;
+    };
+    Case const cases[] = {
+        {"ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff", "0000000000000000000000000000000000000000000000000000000000000001", "ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff"},
+        {"ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff", "ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff", "0000000000000000000000000000000000000000000000000000000000000001"},
+        {"ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff", "0000000000000000000000000000000000000000000000010000000000000001", "0000000000000000ffffffffffffffff0000000000000000ffffffffffffffff"},
+        {"8000000000000000000000000000000000000000000000000000000000003039", "000000000000000000000000000000000000000000000000ffffffffffffffff", "0000000000000000800000000000000080000000000000008000000000000000"},
+        {"d76d4330f1446beab0c11fdecb91ce375bc8fbbcbde5c0994164d8399f767c45", "00000000000000000000000000000000000000007814e8a25f2dd97f1cfb10f6", "000000000000000000000001cb43bce99a05dd8b2fe2a7728e54b1f32fc92d17"},
+        {"ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff", "00000000ffff0000000000000000000000000000000000000000000000000001", "0000000000000000000000000000000000000000000000000000000100010001"},
+        {"00000000000000008000000000000000ffffffffffffffff0000000000000000", "0000000000000000000000000000000080000000000000000000000000000001", "0000000000000000000000000000000000000000000000010000000000000001"},
+        {"0000000000000000000000000000000000000000000000000000000000000005", "0000000000000000000000000000000000000000000000000000000000000007", "0000000000000000000000000000000000000000000000000000000000000000"},
+    };
+    for (auto const& c : cases) {
+        CHECK(FromHex(c.x) / FromHex(c.y) == FromHex(c.quotient));
+        CHECK(DivideShiftSubtract(FromHex(c.x), FromHex(c.y)) == FromHex(c.quotient));
+    }
+
+    bool fThrew = false;
+    try {
+        arith_uint256(1) / arith_uint256();
+    } catch (std::runtime_error const&) {
+        fThrew = true;
+    }
+    CHECK(fThrew);
+
+    std::mt19937_64 rng(20);
+    auto random = [&rng]() {
+        arith_uint256 x;
+        for (int i = 0; i < 4; ++i) {
+            x = (x << 64) + arith_uint256(rng());
+        }
+        return x >> unsigned(rng() % 256);
+    };
+    size_t nMismatches = 0;
+    for (int i = 0; i < 20000; ++i) {
+        arith_uint256 const x = random();
+        arith_uint256 y = random();
+        if (y == 0) {
+            y = 1;
+        }
+        arith_uint256 const quotient = x / y;
+        nMismatches += quotient != DivideShiftSubtract(x, y);
+        arith_uint256 remainder = x;
+        remainder -= quotient * y;
+        nMismatches += remainder >= y;
+    }
+    CHECK(nMismatches == 0);
+}
+
+// CalculateASERT on mainnet parameters, against an exact Python port of the
+// algorithm (truncated division, floored shifts, 256-bit wrap-around).
+struct ASERTCase {
+    uint32_t nRefBits;
+    int64_t nTimeDiff;
+    int64_t nHeightDiff;
+    char const* target;
+};
+
+ASERTCase const asertCases[] = {
+    {0x1804dafe, 600, 1, "000000000000000004dafe000000000000000000000000000000000000000000"},
+    {0x1804dafe, 0, 1, "000000000000000004d8061fb900000000000000000000000000000000000000"},
+    {0x1804dafe, 1200, 1, "000000000000000004ddfd28c400000000000000000000000000000000000000"},
+    {0x1804dafe, 600000, 1000, "000000000000000004dafe000000000000000000000000000000000000000000"},
+    {0x1804dafe, 772800, 1000, "000000000000000009b5fc000000000000000000000000000000000000000000"},
+    {0x1804dafe, 427200, 1000, "0000000000000000026d7f000000000000000000000000000000000000000000"},
+    {0x1804dafe, 686400, 1000, "000000000000000006ddb4e1fc00000000000000000000000000000000000000"},
+    {0x1804dafe, -3600, 10, "000000000000000004ac22a3cd00000000000000000000000000000000000000"},
+    {0x1804dafe, 123456789, 100, "00000000ffffffffffffffffffffffffffffffffffffffffffffffffffffffff"},
+    {0x1804dafe, -123456789, 100, "0000000000000000000000000000000000000000000000000000000000000001"},
+    {0x1d00ffff, 1000000, 1, "00000000ffffffffffffffffffffffffffffffffffffffffffffffffffffffff"},
+    {0x1d00ffff, 3000, 5, "00000000ffff0000000000000000000000000000000000000000000000000000"},
+    {0x1c0ffff0, 86407, 144, "000000000ffffffff00000000000000000000000000000000000000000000000"},
+    {0x1804dafe, 31536017, 52560, "000000000000000004db116bf800000000000000000000000000000000000000"},
+};
+
+void TestCalculateASERT() {
+    auto const params = MainnetParams();
+    arith_uint256 const powLimit = UintToArith256(params.powLimit);
+    for (auto const& c : asertCases) {
+        arith_uint256 const refTarget = arith_uint256().SetCompact(c.nRefBits);
+        arith_uint256 const target = CalculateASERT(refTarget, params.nPowTargetSpacing, c.nTimeDiff, c.nHeightDiff,
+                                                    powLimit, params.nDAAHalfLife, false);
+        CHECK(target == FromHex(c.target));
+    }
+
+    // The batch agrees with the table, one reference block per call.
+    for (auto const& c : asertCases) {
+        uint32_t nBits;
+        CalculateASERTBatch(c.nRefBits, &c.nTimeDiff, &c.nHeightDiff, 1, params, &nBits);
+        CHECK(nBits == FromHex(c.target).GetCompact());
+    }
+}
+
+// Every ASERT kernel this CPU runs against the one-at-a-time
+// CalculateASERTShiftsAndFactor, and the targets they give against
+// CalculateASERT. The inputs mix typical lanes with lanes out of the range
+// the vector kernels handle, which they must hand to the scalar path.
+void TestASERTKernels() {
+    auto const params = MainnetParams();
+    arith_uint256 const powLimit = UintToArith256(params.powLimit);
+    arith_uint256 const refTarget = arith_uint256().SetCompact(0x1804dafe);
+
+    std::mt19937_64 rng(3);
+    constexpr size_t n = 1003;   // not a multiple of any vector width
+    std::vector<int64_t> timeDiffs(n);
+    std::vector<int64_t> heightDiffs(n);
+    for (size_t i = 0; i < n; ++i) {
+        heightDiffs[i] = int64_t(rng() % 200000);
+        timeDiffs[i] = 600 * heightDiffs[i] + int64_t(rng() % 2000001) - 1000000;
+        if (i % 50 == 7) {
+            timeDiffs[i] = int64_t(rng() % (int64_t(1) << 40)) - (int64_t(1) << 39);
+        }
+    }
+
+    for (int64_t nHalfLife : {params.nDAAHalfLife, int64_t(3600)}) {
+        std::vector<int64_t> shifts(n);
+        std::vector<uint64_t> factors(n);
+        for (size_t i = 0; i < n; ++i) {
+            CalculateASERTShiftsAndFactor(params.nPowTargetSpacing, timeDiffs[i], heightDiffs[i], nHalfLife,
+                                          shifts[i], factors[i]);
+        }
+
+        size_t nMismatches = 0;
+        for (size_t i = 0; i < n; ++i) {
+            arith_uint256 const target = CalculateASERT(refTarget, params.nPowTargetSpacing, timeDiffs[i],
+                                                        heightDiffs[i], powLimit, nHalfLife, false);
+            nMismatches += ApplyASERTShiftsAndFactor(refTarget, shifts[i], factors[i], powLimit) != target;
+        }
+        CHECK(nMismatches == 0);
+
+        int nKernels = 0;
+        for (char const* name : {"scalar", "avx2", "avx512"}) {
+            std::vector<int64_t> kernelShifts(n);
+            std::vector<uint64_t> kernelFactors(n);
+            if ( ! CalculateASERTShiftsAndFactorsOn(name, params.nPowTargetSpacing, nHalfLife, timeDiffs.data(),
+                                                    heightDiffs.data(), n, kernelShifts.data(),
+                                                    kernelFactors.data())) {
+                continue;
+            }
+            ++nKernels;
+            CHECK(kernelShifts == shifts);
+            CHECK(kernelFactors == factors);
+        }
+        CHECK(nKernels >= 1);
+    }
+    CHECK( ! CalculateASERTShiftsAndFactorsOn("none", 600, 3600, nullptr, nullptr, 0, nullptr, nullptr));
+}
+
+// Block times of a test chain: on schedule on average, with jitter and drift.
+int64_t ChainTime(int nHeight) {
+    return 1605447844 + 600 * int64_t(nHeight) + (int64_t(nHeight) * 7919) % 1201 - 600 + (nHeight / 100) * 37;
+}
+
+// The next nBits of the test chain, with its first block as the reference
+// block, through every entry point: CBlockIndex, CChainStore, the range
+// version and ASERTContext. Reference values from the Python port.
+void TestNextWorkRequired() {
+    auto const params = MainnetParams();
+    constexpr int n = 1000;
+    constexpr uint32_t nRefBits = 0x1804dafe;
+
+    std::vector<CBlockIndex> blocks(n);
+    CChainStore chain(0);
+    for (int i = 0; i < n; ++i) {
+        blocks[i].nHeight = i;
+        blocks[i].nTime = uint32_t(ChainTime(i));
+        blocks[i].nBits = nRefBits;
+        blocks[i].pprev = i > 0 ? &blocks[i - 1] : nullptr;
+        chain.push_back(uint32_t(ChainTime(i)), nRefBits);
+    }
+    std::vector<uint32_t> range(n);
+    GetNextASERTWorkRequiredRange(chain, 0, 0, n, params, range.data());
+    ASERTContext const context(blocks[0], params);
+    CBlockHeader const blockDummy = CBlockHeader();
+
+    struct Case {
+        int nPrevHeight;
+        uint32_t nBits;
+    };
+    Case const cases[] = {
+        {0, 0x1804dafe},
+        {1, 0x1804de8e},
+        {2, 0x1804dc1c},
+        {10, 0x1804e0a0},
+        {100, 0x1804dd61},
+        {500, 0x1804e0f2},
+        {999, 0x1804dd1d},
+    };
+    for (auto const& c : cases) {
+        CHECK(GetNextASERTWorkRequired(&blocks[c.nPrevHeight], &blockDummy, params, &blocks[0], false) == c.nBits);
+        CHECK(GetNextASERTWorkRequired(chain, c.nPrevHeight, 0, params) == c.nBits);
+        CHECK(range[c.nPrevHeight] == c.nBits);
+        CHECK(context.next(ChainTime(c.nPrevHeight), c.nPrevHeight) == c.nBits);
+    }
+
+    size_t nMismatches = 0;
+    for (int i = 0; i < n; ++i) {
+        uint32_t const nBits = GetNextASERTWorkRequired(&blocks[i], &blockDummy, params, &blocks[0], false);
+        nMismatches += GetNextASERTWorkRequired(chain, i, 0, params) != nBits;
+        nMismatches += range[i] != nBits;
+        nMismatches += context.next(ChainTime(i), i) != nBits;
+    }
+    CHECK(nMismatches == 0);
+}
+
+// FindFirstASERTBitsMismatch on a valid chain of several chunks and on copies
+// corrupted at one or two heights, on one and several threads.
+void TestFindFirstASERTBitsMismatch() {
+    auto const params = MainnetParams();
+    constexpr int n = 20000;
+
+    CChainStore valid(0);
+    valid.push_back(uint32_t(ChainTime(0)), 0x1804dafe);
+    for (int i = 1; i < n; ++i) {
+        valid.push_back(uint32_t(ChainTime(i)), GetNextASERTWorkRequired(valid, i - 1, 0, params));
+    }
+
+    auto corrupt = [&valid](std::vector<int> const& heights) {
+        CChainStore chain(0);
+        for (int i = 0; i <= valid.TipHeight(); ++i) {
+            bool const fBad = std::find(heights.begin(), heights.end(), i) != heights.end();
+            chain.push_back(valid.GetTime(i), valid.GetBits(i) + (fBad ? 1 : 0));
+        }
+        return chain;
+    };
+
+    struct Case {
+        std::vector<int> corrupted;
+        int nFirstHeight;
+        int nMismatch;
+    };
+    Case const cases[] = {
+        {{}, 1, -1},
+        {{}, n - 1, -1},
+        {{1}, 1, 1},
+        {{4096}, 1, 4096},
+        {{4097}, 1, 4097},
+        {{12345}, 1, 12345},
+        {{n - 1}, 1, n - 1},
+        {{300, 15000}, 1, 300},
+        {{300, 15000}, 301, 15000},
+        {{300}, 301, -1},
+    };
+    for (auto const& c : cases) {
+        CChainStore const chain = corrupt(c.corrupted);
+        for (unsigned int nThreads : {1u, 3u, 0u}) {
+            CHECK(FindFirstASERTBitsMismatch(chain, 0, c.nFirstHeight, params, nThreads) == c.nMismatch);
+        }
+    }
+}
+
+// Bitcoin's genesis block header and its hash.
+char const* const genesisHeaderHex =
+    "0100000000000000000000000000000000000000000000000000000000000000"
+    "000000003ba3edfd7a7b12b27ac72c3e67768f617fc81bc3888a51323a9fb8aa"
+    "4b1e5e4a29ab5f49ffff001d1dac2b7c";
+char const* const genesisHashHex = "000000000019d6689c085ae165831e934ff763ae46a2a6c172b3f1b60a8ce26f";
+
+std::vector<uint8_t> GenesisHeader() {
+    std::vector<uint8_t> header(CBlockHeaderView::SIZE);
+    for (size_t i = 0; i < header.size(); ++i) {
+        char const byte[3] = {genesisHeaderHex[2 * i], genesisHeaderHex[2 * i + 1], 0};
+        header[i] = uint8_t(std::strtoul(byte, nullptr, 16));
+    }
+    return header;
+}
+
+arith_uint256 HashAt(std::vector<uint8_t> const& hashes, size_t i) {
+    uint256 hash;
+    std::memcpy(hash.begin(), &hashes[32 * i], 32);
+    return UintToArith256(hash);
+}
+
+// Every SHA256dHeaders kernel against Python's hashlib on synthetic headers,
+// odd counts included, and on the genesis header.
+void TestSHA256dHeaders() {
+    constexpr size_t count = 37;
+    std::vector<uint8_t> headers(count * CBlockHeaderView::SIZE);
+    for (size_t i = 0; i < count; ++i) {
+        for (size_t j = 0; j < CBlockHeaderView::SIZE; ++j) {
+            headers[i * CBlockHeaderView::SIZE + j] = uint8_t(i * 37 + j * 11 + (j * j) % 13);
+        }
+    }
+    struct Case {
+        size_t index;
+        char const* hash;
+    };
+    Case const cases[] = {
+        {0, "dc2932fb2e5ab74e1eb458de39639c4a21f5f351ce8db014e425001b55cf9f2e"},
+        {7, "404810d9ebef266dacf47f579d440c69df93c08aa33daf3741370b1801600302"},
+        {8, "a4b14f9bf6037df0ced680492190b574e790f3637c1d1c3ea4f83a7f2ac5c159"},
+        {36, "0334d9bec6e6b05690abcdaec74b47819f5cfd5ac77cff46273ce3f73f7d24e6"},
+    };
+    std::vector<uint8_t> const genesis = GenesisHeader();
+
+    std::vector<uint8_t> expected(count * 32);
+    CHECK(SHA256dHeadersOn("scalar", headers.data(), count, expected.data()));
+    for (auto const& c : cases) {
+        CHECK(HashAt(expected, c.index) == FromHex(c.hash));
+    }
+
+    int nKernels = 0;
+    for (char const* name : {"shani", "avx2", "scalar"}) {
+        std::vector<uint8_t> hashes(count * 32);
+        for (size_t n : {count, size_t(1), size_t(2), size_t(9)}) {
+            std::fill(hashes.begin(), hashes.end(), 0);
+            if ( ! SHA256dHeadersOn(name, headers.data(), n, hashes.data())) {
+                break;
+            }
+            CHECK(std::equal(hashes.begin(), hashes.begin() + 32 * n, expected.begin()));
+            CHECK(std::all_of(hashes.begin() + 32 * n, hashes.end(), [](uint8_t b) { return b == 0; }));
+        }
+        std::vector<uint8_t> hash(32);
+        if (SHA256dHeadersOn(name, genesis.data(), 1, hash.data())) {
+            ++nKernels;
+            CHECK(HashAt(hash, 0) == FromHex(genesisHashHex));
+        }
+    }
+    CHECK(nKernels >= 1);
+    CHECK( ! SHA256dHeadersOn("none", headers.data(), count, expected.data()));
+
+    std::vector<uint8_t> hashes(count * 32);
+    SHA256dHeaders(headers.data(), count, hashes.data());
+    CHECK(hashes == expected);
+    CHECK(UintToArith256(GetBlockHash(CBlockHeaderView(genesis.data()))) == FromHex(genesisHashHex));
+}
+
+// FindFirstInvalidProofOfWork on copies of the genesis header, with one or
+// two of them broken by a wrong nonce or an invalid nBits.
+void TestFindFirstInvalidProofOfWork() {
+    auto const params = MainnetParams();
+    std::vector<uint8_t> const genesis = GenesisHeader();
+    CHECK(CheckProofOfWork(GetBlockHash(CBlockHeaderView(genesis.data())), 0x1d00ffff, params));
+
+    constexpr size_t count = 41;
+    std::vector<uint8_t> valid;
+    for (size_t i = 0; i < count; ++i) {
+        valid.insert(valid.end(), genesis.begin(), genesis.end());
+    }
+    CHECK(FindFirstInvalidProofOfWork(valid.data(), count, params) == count);
+    CHECK(FindFirstInvalidProofOfWork(valid.data(), 0, params) == 0);
+
+    // Nonce, powLimit exceeded, negative, zero and overflowing targets.
+    struct Break {
+        size_t offset;
+        uint32_t value;
+    };
+    Break const breaks[] = {
+        {76, 0x7c2bac1e},
+        {72, 0x1d01ffff},
+        {72, 0x1d80ffff},
+        {72, 0x1d000000},
+        {72, 0xff00ffff},
+    };
+    for (auto const& b : breaks) {
+        for (size_t const k : {size_t(0), size_t(7), size_t(8), size_t(count - 1)}) {
+            std::vector<uint8_t> headers = valid;
+            WriteLE32(&headers[k * CBlockHeaderView::SIZE + b.offset], b.value);
+            CBlockHeaderView const header(&headers[k * CBlockHeaderView::SIZE]);
+            CHECK( ! CheckProofOfWork(GetBlockHash(header), header.GetBits(), params));
+            CHECK(FindFirstInvalidProofOfWork(headers.data(), count, params) == k);
+            if (k + 2 < count) {
+                WriteLE32(&headers[(k + 2) * CBlockHeaderView::SIZE + b.offset], b.value);
+                CHECK(FindFirstInvalidProofOfWork(headers.data(), count, params) == k);
+            }
+        }
+    }
+}
+
+// GetBlockProof against Python's 2**256 // (target + 1), invalid targets
+// included, and ComputeChainWork over several chunks on any number of
+// threads against the serial sum and Python, wrapping around 2^256 as well.
+void TestChainWork() {
+    struct ProofCase {
+        uint32_t nBits;
+        char const* proof;
+    };
+    ProofCase const proofCases[] = {
+        {0x1d00ffff, "0000000000000000000000000000000000000000000000000000000100010001"},
+        {0x1804dafe, "000000000000000000000000000000000000000000000034b9715de42433f55f"},
+        {0x1b0404cb, "00000000000000000000000000000000000000000000000000003fb3ab764c00"},
+        {0x207fffff, "0000000000000000000000000000000000000000000000000000000000000002"},
+        {0x03000001, "8000000000000000000000000000000000000000000000000000000000000000"},
+        {0x2100ffff, "0000000000000000000000000000000000000000000000000000000000000001"},
+        {0x01003456, "0000000000000000000000000000000000000000000000000000000000000000"},
+        {0x04923456, "0000000000000000000000000000000000000000000000000000000000000000"},
+        {0xff123456, "0000000000000000000000000000000000000000000000000000000000000000"},
+        {0x00000000, "0000000000000000000000000000000000000000000000000000000000000000"},
+    };
+    for (auto const& c : proofCases) {
+        CHECK(GetBlockProof(c.nBits) == FromHex(c.proof));
+    }
+
+    constexpr size_t count = 50000;
+    uint32_t const targets[] = {0x1d00ffff, 0x1804dafe, 0x1b0404cb, 0x1c0ffff0, 0x207fffff};
+    std::vector<uint32_t> nBits(count);
+    for (size_t i = 0; i < count; ++i) {
+        nBits[i] = targets[(i / 1000) % std::size(targets)];
+    }
+
+    std::vector<arith_uint256> proofs(count);
+    GetBlockProofs(nBits.data(), count, proofs.data());
+    size_t nMismatches = 0;
+    for (size_t i = 0; i < count; ++i) {
+        nMismatches += proofs[i] != GetBlockProof(nBits[i]);
+    }
+    CHECK(nMismatches == 0);
+
+    struct WorkCase {
+        size_t index;
+        char const* work;
+    };
+    WorkCase const workCases[] = {
+        {0, "00000000000000000000000000000000000000000123456789abcdf000010001"},
+        {16383, "00000000000000000000000000000000000000000125fe5adf283a4fac3f0258"},
+        {16384, "00000000000000000000000000000000000000000125fe8f98999833d072f7b7"},
+        {32768, "00000000000000000000000000000000000000000128e7164421143f3206aae0"},
+        {49999, "0000000000000000000000000000000000000000012b50f36fca602182ac7520"},
+    };
+    for (arith_uint256 const& nBaseWork : {FromHex("0123456789abcdef00000000"), arith_uint256(~arith_uint256())}) {
+        std::vector<arith_uint256> serial(count);
+        arith_uint256 work = nBaseWork;
+        for (size_t i = 0; i < count; ++i) {
+            work += proofs[i];
+            serial[i] = work;
+        }
+        for (unsigned int nThreads : {1u, 2u, 3u, 0u}) {
+            std::vector<arith_uint256> chainWork(count);
+            ComputeChainWork(nBits.data(), count, nBaseWork, chainWork.data(), nThreads);
+            CHECK(chainWork == serial);
+        }
+    }
+
+    std::vector<arith_uint256> chainWork(count);
+    ComputeChainWork(nBits.data(), count, FromHex("0123456789abcdef00000000"), chainWork.data(), 3);
+    for (auto const& c : workCases) {
+        CHECK(chainWork[c.index] == FromHex(c.work));
+    }
+
+    std::vector<uint32_t> nTimes(count);
+    for (size_t i = 0; i < count; ++i) {
+        nTimes[i] = uint32_t(ChainTime(int(i)));
+    }
+    CChainStore chain(0, true);
+    chain.append(nTimes.data(), nBits.data(), count, 3);
+    CHECK(chain.GetChainWork(int(count) - 1) + FromHex("0123456789abcdef00000000") == chainWork.back());
+}
+
+// A test chain whose every seventh block is timestamped before its parent,
+// with the targets of three blocks in turn.
+int64_t MessyChainTime(int nHeight) {
+    return ChainTime(nHeight) - (nHeight % 7 == 3 ? 1500 : 0);
+}
+
+uint32_t MessyChainBits(int nHeight) {
+    static uint32_t const nBits[] = {0x1804dafe, 0x1804e0a0, 0x1804d5c3};
+    return nBits[nHeight % 3];
+}
+
+// Median-of-three ASERT with the block at height 2 as the anchor, through
+// CBlockIndex, CChainStore and the aserti3-mo3-416-cpp variant. Reference
+// values from mining.py's suitable_block_index and the Python port.
+void TestNextMo3WorkRequired() {
+    auto const params = MainnetParams();
+    constexpr int n = 1000;
+    constexpr int nAnchorHeight = 2;
+
+    std::vector<CBlockIndex> blocks(n);
+    CChainStore chain(0);
+    for (int i = 0; i < n; ++i) {
+        blocks[i].nHeight = i;
+        blocks[i].nTime = uint32_t(MessyChainTime(i));
+        blocks[i].nBits = MessyChainBits(i);
+        blocks[i].pprev = i > 0 ? &blocks[i - 1] : nullptr;
+        chain.push_back(uint32_t(MessyChainTime(i)), MessyChainBits(i));
+    }
+    ASERTiVariant variant;
+    CHECK(GetASERTiVariant("aserti3-mo3-416-cpp", variant));
+    CBlockHeader const blockDummy = CBlockHeader();
+
+    int const suitable[][2] = {{2, 1}, {3, 1}, {4, 2}, {5, 4}, {9, 8}, {10, 8}, {11, 9}};
+    for (auto const& c : suitable) {
+        CHECK(GetSuitableBlock(&blocks[c[0]])->nHeight == c[1]);
+        CHECK(GetSuitableBlockHeight(chain, c[0]) == c[1]);
+    }
+
+    struct Case {
+        int nPrevHeight;
+        uint32_t nBits;
+    };
+    Case const cases[] = {
+        {2, 0x1804e0a0},
+        {3, 0x1804e0a0},
+        {4, 0x1804de32},
+        {5, 0x1804df51},
+        {6, 0x1804e2df},
+        {10, 0x1804e18e},
+        {11, 0x1804df21},
+        {100, 0x1804e1b1},
+        {500, 0x1804e1b1},
+        {999, 0x1804e1a2},
+    };
+    for (auto const& c : cases) {
+        CHECK(GetNextASERTMo3WorkRequired(&blocks[c.nPrevHeight], &blockDummy, params, &blocks[nAnchorHeight], false) == c.nBits);
+        CHECK(GetNextASERTMo3WorkRequired(chain, c.nPrevHeight, nAnchorHeight, params) == c.nBits);
+        CHECK(GetNextASERTiWorkRequired(variant, chain, c.nPrevHeight, nAnchorHeight, params) == c.nBits);
+    }
+
+    size_t nMismatches = 0;
+    for (int i = nAnchorHeight; i < n; ++i) {
+        uint32_t const nBits = GetNextASERTMo3WorkRequired(&blocks[i], &blockDummy, params, &blocks[nAnchorHeight], false);
+        nMismatches += GetNextASERTMo3WorkRequired(chain, i, nAnchorHeight, params) != nBits;
+        nMismatches += GetNextASERTiWorkRequired(variant, chain, i, nAnchorHeight, params) != nBits;
+    }
+    CHECK(nMismatches == 0);
+}
+
+// The registered difficulty algorithms on the test chain of
+// TestNextMo3WorkRequired, stored from height 1000: single blocks against
+// reference values from mining.py's formulas, ranges against single blocks
+// for every algorithm.
+void TestDifficultyAlgorithms() {
+    auto const params = MainnetParams();
+    constexpr int nFirstHeight = 1000;
+    constexpr int n = 600;
+
+    CChainStore chain(nFirstHeight, true);
+    for (int i = 0; i < n; ++i) {
+        chain.push_back(uint32_t(MessyChainTime(i)), MessyChainBits(i));
+    }
+
+    struct Case {
+        char const* name;
+        int nMinPrevHeight;
+        int nPrevHeights[4];
+        uint32_t nBits[4];
+    };
+    Case const cases[] = {
+        {"wtema-144", 1001, {1001, 1002, 1100, 1599}, {0x1804eaed, 0x1804cec5, 0x1804da1b, 0x1804f577}},
+        {"lwma-045", 1045, {1045, 1046, 1300, 1599}, {0x180481cd, 0x1804ccef, 0x1804bb01, 0x1804ee98}},
+        {"lwma-144", 1144, {1144, 1145, 1400, 1599}, {0x1804ddbc, 0x1804cfab, 0x1804dda5, 0x1804e1de}},
+        {"cw-144", 1146, {1146, 1147, 1400, 1599}, {0x1804d2cf, 0x1804dd04, 0x1804dd0d, 0x1804d9c8}},
+        {"aserti3-416-cpp", 1000, {1000, 1001, 1300, 1599}, {0x1804dafe, 0x1804de8e, 0x1804dc26, 0x1804df95}},
+    };
+    for (auto const& c : cases) {
+        DifficultyAlgorithm const* algo = GetDifficultyAlgorithm(c.name);
+        CHECK(algo != nullptr);
+        if (algo == nullptr) {
+            continue;
+        }
+        CHECK(algo->GetName() == c.name);
+        CHECK(algo->GetMinPrevHeight(chain) == c.nMinPrevHeight);
+        for (int i = 0; i < 4; ++i) {
+            CHECK(algo->GetNextWorkRequired(chain, c.nPrevHeights[i], params) == c.nBits[i]);
+        }
+    }
+    CHECK(GetDifficultyAlgorithm("none") == nullptr);
+
+    auto const names = GetDifficultyAlgorithmNames();
+    CHECK(names.size() >= std::size(cases));
+    size_t nMismatches = 0;
+    for (auto const& name : names) {
+        DifficultyAlgorithm const* algo = GetDifficultyAlgorithm(name);
+        if (algo == nullptr) {
+            ++nMismatches;
+            continue;
+        }
+        int const nFirstPrevHeight = algo->GetMinPrevHeight(chain);
+        size_t const count = size_t(nFirstHeight + n - nFirstPrevHeight);
+        std::vector<uint32_t> range(count);
+        algo->GetNextWorkRequiredRange(chain, nFirstPrevHeight, count, params, range.data());
+        for (size_t i = 0; i < count; ++i) {
+            nMismatches += range[i] != algo->GetNextWorkRequired(chain, nFirstPrevHeight + int(i), params);
+        }
+    }
+    CHECK(nMismatches == 0);
+}
+
+bool WriteFile(std::string const& path, std::vector<uint8_t> const& bytes) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<char const*>(bytes.data()), std::streamsize(bytes.size()));
+    return bool(file);
+}
+
+bool ThrowsOnMap(std::string const& path) {
+    try {
+        CHeaderFile const file(path);
+    } catch (std::runtime_error const&) {
+        return true;
+    }
+    return false;
+}
+
+// CHeaderFile on a temporary dump of genesis copies with distinct times and
+// targets, an empty dump, a truncated one and a missing file, and
+// AppendHeaders from the mapping.
+void TestHeaderFile() {
+    std::string const path = (std::filesystem::temp_directory_path() / "aserti3-416_test_headers.dat").string();
+    std::vector<uint8_t> const genesis = GenesisHeader();
+    constexpr size_t count = 5;
+    std::vector<uint8_t> dump;
+    for (size_t i = 0; i < count; ++i) {
+        dump.insert(dump.end(), genesis.begin(), genesis.end());
+        WriteLE32(&dump[i * CBlockHeaderView::SIZE + 68], uint32_t(ChainTime(int(i))));
+        WriteLE32(&dump[i * CBlockHeaderView::SIZE + 72], MessyChainBits(int(i)));
+    }
+
+    CHECK(WriteFile(path, dump));
+    {
+        CHeaderFile const file(path);
+        CHECK(file.size() == count && ! file.empty());
+        CHECK(std::equal(dump.begin(), dump.end(), file.data()));
+        CHECK(file[3].GetTime() == uint32_t(ChainTime(3)) && file[3].GetBits() == MessyChainBits(3));
+
+        CChainStore chain(10, true);
+        AppendHeaders(chain, file);
+        AppendHeaders(chain, file, 0);
+        CHECK(chain.TipHeight() == 10 + 2 * int(count) - 1);
+        size_t nMismatches = 0;
+        for (size_t i = 0; i < 2 * count; ++i) {
+            int const nHeight = 10 + int(i);
+            nMismatches += chain.GetTime(nHeight) != uint32_t(ChainTime(int(i % count)));
+            nMismatches += chain.GetBits(nHeight) != MessyChainBits(int(i % count));
+        }
+        CHECK(nMismatches == 0);
+        arith_uint256 work;
+        for (size_t i = 0; i < 2 * count; ++i) {
+            work += GetBlockProof(MessyChainBits(int(i % count)));
+        }
+        CHECK(chain.GetChainWork(chain.TipHeight()) == work);
+    }
+
+    CHECK(WriteFile(path, {}));
+    {
+        CHeaderFile const file(path);
+        CHECK(file.size() == 0 && file.empty());
+        CChainStore chain(0);
+        AppendHeaders(chain, file);
+        CHECK(chain.empty());
+    }
+
+    dump.pop_back();
+    CHECK(WriteFile(path, dump));
+    CHECK(ThrowsOnMap(path));
+
+    std::filesystem::remove(path);
+    CHECK(ThrowsOnMap(path));
+}
+
+// Philox4x32-10 known answers from the Random123 distribution (kat_vectors),
+// the generator's outputs against the blocks, and the batch exponential
+// sampler against one variate at a time and std::log, at odd positions and
+// counts.
+void TestPhilox() {
+    struct Case {
+        uint32_t key[2];
+        uint64_t nCounter;
+        uint64_t nStream;
+        uint32_t out[4];
+    };
+    Case const cases[] = {
+        {{0, 0}, 0, 0, {0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8}},
+        {{0xffffffff, 0xffffffff}, ~uint64_t(0), ~uint64_t(0), {0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd}},
+        {{0xa4093822, 0x299f31d0}, 0x85a308d3243f6a88, 0x0370734413198a2e, {0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}},
+    };
+    for (auto const& c : cases) {
+        uint32_t out[4];
+        Philox4x32::Block(c.key, c.nCounter, c.nStream, out);
+        CHECK(std::equal(out, out + 4, c.out));
+    }
+
+    constexpr uint64_t seed = 0x0123456789abcdef;
+    constexpr uint64_t stream = 7;
+    Philox4x32 rng(seed, stream);
+    uint32_t const key[2] = {uint32_t(seed), uint32_t(seed >> 32)};
+    size_t nMismatches = 0;
+    for (uint64_t nCounter = 0; nCounter < 100; ++nCounter) {
+        uint32_t out[4];
+        Philox4x32::Block(key, nCounter, stream, out);
+        nMismatches += rng() != (uint64_t(out[0]) | uint64_t(out[1]) << 32);
+        nMismatches += rng() != (uint64_t(out[2]) | uint64_t(out[3]) << 32);
+    }
+    CHECK(nMismatches == 0);
+    CHECK(rng.Position() == 200);
+
+    Philox4x32 skipped(seed, stream);
+    skipped.Discard(151);
+    Philox4x32 drawn(seed, stream);
+    for (int i = 0; i < 151; ++i) {
+        drawn();
+    }
+    CHECK(skipped() == drawn());
+
+    // One variate per call takes the scalar path, whatever the kernel.
+    for (size_t const count : {size_t(1), size_t(7), size_t(1000)}) {
+        Philox4x32 batch(seed, stream);
+        Philox4x32 single(seed, stream);
+        Philox4x32 uniform(seed, stream);
+        batch();
+        single();
+        uniform();
+        std::vector<double> out(count);
+        SampleExponential(batch, out.data(), count);
+        size_t nNotClose = 0;
+        nMismatches = 0;
+        for (size_t i = 0; i < count; ++i) {
+            double x;
+            SampleExponential(single, &x, 1);
+            nMismatches += out[i] != x;
+            double const reference = -std::log(1 - uniform.Uniform());
+            nNotClose += std::fabs(out[i] - reference) > 4e-16 * std::fabs(reference);
+        }
+        CHECK(nMismatches == 0);
+        CHECK(nNotClose == 0);
+        CHECK(batch.Position() == single.Position());
+        CHECK(batch() == single());
+    }
+}
+
+bool SameStats(SimulRunStats const& a, SimulRunStats const& b) {
+    return a.mean == b.mean && a.stdev == b.stdev && a.median == b.median && a.max == b.max;
+}
+
+// Simulation runs only depend on (seed, run): the same on any number of
+// threads and when run one at a time. Summaries against hand computed values.
+void TestSimulations() {
+    auto const params = MainnetParams();
+    SimulParams simul;
+    simul.nBlocks = 2000;
+    SimulScenario scenario;
+    CHECK(GetSimulScenario("stable", scenario));
+    CHECK( ! GetSimulScenario("none", scenario));
+    CHECK(GetSimulScenario("default", scenario));
+
+    constexpr uint64_t seed = 42;
+    constexpr size_t count = 4;
+    auto const runs = RunSimulations(simul, scenario, params, seed, count, 1);
+    CHECK(runs.size() == count);
+    for (unsigned int nThreads : {3u, 0u}) {
+        auto const other = RunSimulations(simul, scenario, params, seed, count, nThreads);
+        size_t nMismatches = other.size() == count ? 0 : 1;
+        for (size_t i = 0; i < count && i < other.size(); ++i) {
+            nMismatches += ! SameStats(runs[i], other[i]);
+        }
+        CHECK(nMismatches == 0);
+    }
+    for (size_t i = 0; i < count; ++i) {
+        CHECK(SameStats(runs[i], RunSimulation(simul, scenario, params, seed, i)));
+        CHECK(runs[i].mean > 500 && runs[i].mean < 700);
+        CHECK(runs[i].max >= runs[i].median && runs[i].median >= 0);
+    }
+    CHECK( ! SameStats(runs[0], runs[1]));
+    CHECK( ! SameStats(runs[0], RunSimulation(simul, scenario, params, seed + 1, 0)));
+
+    std::vector<SimulRunStats> const made = {
+        {1, 5, 10, 100},
+        {2, 5, 20, 200},
+        {3, 5, 30, 300},
+        {4, 5, 40, 400},
+        {10, 5, 50, 1000},
+    };
+    auto const summary = SummarizeSimulations(made);
+    CHECK(summary.mean.min == 1 && summary.mean.max == 10);
+    CHECK(summary.mean.mean == 4);
+    CHECK(summary.mean.stdev == std::sqrt(12.5));
+    CHECK(summary.mean.median == 3);
+    CHECK(summary.stdev.mean == 5 && summary.stdev.stdev == 0 && summary.stdev.median == 5);
+    CHECK(summary.median.mean == 30 && summary.median.median == 30);
+    CHECK(summary.max.min == 100 && summary.max.max == 1000 && summary.max.mean == 400);
+
+    auto const single = SummarizeSimulations({made[2]});
+    CHECK(single.mean.mean == 3 && single.mean.stdev == 0 && single.mean.median == 3);
+    auto const none = SummarizeSimulations({});
+    CHECK(none.mean.mean == 0 && none.max.max == 0);
+}
+
+} // namespace
+
+int main() {
+    TestCompact();
+    TestMulU64ShiftRight();
+    TestDivision();
+    TestCalculateASERT();
+    TestASERTKernels();
+    TestNextWorkRequired();
+    TestFindFirstASERTBitsMismatch();
+    TestSHA256dHeaders();
+    TestFindFirstInvalidProofOfWork();
+    TestChainWork();
+    TestNextMo3WorkRequired();
+    TestDifficultyAlgorithms();
+    TestHeaderFile();
+    TestPhilox();
+    TestSimulations();
+
+    std::printf("%d checks, %d failed\n", nChecks, nFailures);
+    return nFailures == 0 ? 0 : 1;
+}
@@ -0,0 +1,80 @@
+/**
+ * Copyright (c) 2020 Fernando Pelliccioni
+ */
+
+// Header chain nBits validation, see aserti3-416_validation.hpp.
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <climits>
+#include <thread>
+#include <vector>
+
+#include "aserti3-416_validation.hpp"
+
+namespace {
+
+// Headers per work item: large enough for the batch kernel and to amortize
+// the scheduling, small enough to spread a sync of a few days over the cores.
+constexpr size_t chunkSize = 4096;
+
+} // namespace
+
+int FindFirstASERTBitsMismatch(const CChainStore &chain,
+                               int nRefHeight,
+                               int nFirstHeight,
+                               const Consensus::Params &params,
+                               unsigned int nThreads) {
+    assert(chain.Contains(nRefHeight) && nFirstHeight > nRefHeight);
+    if (nFirstHeight > chain.TipHeight()) {
+        return -1;
+    }
+
+    const size_t count = size_t(chain.TipHeight() - nFirstHeight + 1);
+    const size_t nChunks = (count + chunkSize - 1) / chunkSize;
+    if (nThreads == 0) {
+        nThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    nThreads = unsigned(std::min<size_t>(nThreads, nChunks));
+
+    const uint32_t *bits = chain.Bits() + (nFirstHeight - chain.FirstHeight());
+
+    // Chunks are handed out in height order, so every chunk below the
+    // lowest mismatch found so far gets checked in full.
+    std::atomic<size_t> next {0};
+    std::atomic<int> nFirstMismatch {INT_MAX};
+    auto worker = [&]() {
+        std::vector<uint32_t> expected(chunkSize);
+        for (size_t chunk = next++; chunk < nChunks; chunk = next++) {
+            const size_t begin = chunk * chunkSize;
+            if (nFirstHeight + int(begin) > nFirstMismatch.load(std::memory_order_relaxed)) {
+                break;
+            }
+            const size_t n = std::min(chunkSize, count - begin);
+            GetNextASERTWorkRequiredRange(chain, nRefHeight, nFirstHeight - 1 + int(begin), n, params,
+                                          expected.data());
+            const size_t i = size_t(std::mismatch(expected.begin(), expected.begin() + n, bits + begin).first -
+                                    expected.begin());
+            if (i < n) {
+                const int nHeight = nFirstHeight + int(begin + i);
+                int nCurrent = nFirstMismatch.load(std::memory_order_relaxed);
+                while (nHeight < nCurrent && ! nFirstMismatch.compare_exchange_weak(nCurrent, nHeight)) {
+                }
+                break;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned int i = 1; i < nThreads; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    const int nResult = nFirstMismatch.load();
+    return nResult == INT_MAX ? -1 : nResult;
+}
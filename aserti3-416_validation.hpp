@@ -0,0 +1,26 @@
+#ifndef ASERTI3_416_VALIDATION_HPP_
+#define ASERTI3_416_VALIDATION_HPP_
+
+#include "aserti3-416.hpp"
+
+/**
+ * Checks the nBits of every header in [nFirstHeight, chain.TipHeight()]
+ * against ASERT with nRefHeight as the reference block, as
+ * GetNextASERTWorkRequired(chain, nHeight - 1, nRefHeight, params) would
+ * compute it. nRefHeight must be in the store and below nFirstHeight.
+ *
+ * ASERT targets only depend on the reference block and the parent's height
+ * and time, so the range is split in chunks checked on nThreads worker
+ * threads (0: one per hardware thread), each through the batch kernel.
+ * Chunks above a mismatch already found are skipped.
+ *
+ * Returns the lowest height whose nBits differs from the expected one, or
+ * -1 if they all match. The result does not depend on nThreads.
+ */
+int FindFirstASERTBitsMismatch(const CChainStore &chain,
+                               int nRefHeight,
+                               int nFirstHeight,
+                               const Consensus::Params &params,
+                               unsigned int nThreads);
+
+#endif // ASERTI3_416_VALIDATION_HPP_
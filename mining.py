@@ -164,7 +164,29 @@ def suitable_block_index(index):
 # void CAPI_CBlockIndex_set_nBits(void* ptr, uint32_t nBits) {
 # void CAPI_CBlockIndex_set_nChainWork(void* ptr, void* nChainWork) {
 
+# Persistent native chain: only the states appended since the previous call
+# are sent to the C++ side, the reference block and the tip stay resident.
+# The mo3 algos need the timestamps around the tip too, they keep every
+# state in a native chain store instead.
+cpp_params = aserti3416cpp.Params_GetDefaultMainnetConsensusParams()
+cpp_chain = None
+cpp_chain_size = 0
+cpp_store = None
+cpp_store_size = 0
+
+def reset_cpp_chain():
+    global cpp_chain, cpp_chain_size, cpp_store, cpp_store_size
+    if cpp_chain is not None:
+        aserti3416cpp.ASERTChain_destruct(cpp_chain)
+    if cpp_store is not None:
+        aserti3416cpp.ChainStore_destruct(cpp_store)
+    cpp_chain = None
+    cpp_chain_size = 0
+    cpp_store = None
+    cpp_store_size = 0
+
 def next_bits_aserti_416_cpp(msg, tau, mode=1, mo3=False):
+    global cpp_chain, cpp_chain_size
 
     # const CBlockIndex *prefBlock = pindexPrev->GetAncestor(nRefHeight);
     # assert(prefBlock != nullptr);
@@ -173,39 +195,41 @@ def next_bits_aserti_416_cpp(msg, tau, mode=1, mo3=False):
     # const int32_t nHeightDiff = pindexPrev->nHeight - prefBlock->nHeight;
     # assert(nHeightDiff > 0);
 
-    if mo3:
-        last = suitable_block_index(len(states) - 1)
-        first = suitable_block_index(2)
-    else:
-        last = len(states)-1
-        first = 0
+    if not mo3:
+        if cpp_chain is None or cpp_chain_size > len(states):
+            reset_cpp_chain()
+            cpp_chain = aserti3416cpp.ASERTChain_construct(cpp_params)
+
+        for state in states[cpp_chain_size:]:
+            aserti3416cpp.ASERTChain_append(cpp_chain, state.height, state.timestamp, state.bits)
+        cpp_chain_size = len(states)
 
-    blocks = []
-    for i in range(first, last + 1):
-        state = states[i]
-        block = aserti3416cpp.CBlockIndex_construct()
-        aserti3416cpp.CBlockIndex_set_nTime(block, state.timestamp)
-        aserti3416cpp.CBlockIndex_set_nHeight(block, state.height)
-        aserti3416cpp.CBlockIndex_set_nBits(block, state.bits)
-        blocks.append(block)
+        return aserti3416cpp.ASERTChain_next_work_required(cpp_chain)
 
-    for i in range(len(blocks) - 1, 0, -1):
-        aserti3416cpp.CBlockIndex_set_pprev(blocks[i], blocks[i-1])
+    sync_cpp_store()
 
-    blkHeaderDummy = aserti3416cpp.CBlockHeader_construct()
-    params = aserti3416cpp.Params_GetDefaultMainnetConsensusParams()
-    # nforkHeight = states[first].height
-    nforkHeight = states[0].height
+    # Suitable blocks of states[-1] and states[2], as suitable_block_index.
+    return aserti3416cpp.ChainStore_next_work_required_mo3(
+        cpp_store, states[-1].height, states[2].height, cpp_params)
 
-    # res = aserti3416cpp.GetNextASERTWorkRequired(blocks[-1], blkHeaderDummy, params, nforkHeight)
-    res = aserti3416cpp.GetNextASERTWorkRequired(blocks[-1], blkHeaderDummy, params, blocks[0], False)
+def sync_cpp_store(chain_work=False):
+    '''Appends the states the native chain store does not have yet.'''
+    global cpp_store, cpp_store_size
+    if cpp_store is None or cpp_store_size > len(states):
+        reset_cpp_chain()
+        cpp_store = aserti3416cpp.ChainStore_construct(states[0].height, chain_work)
+    elif chain_work:
+        aserti3416cpp.ChainStore_enable_chain_work(cpp_store)
 
-    # aserti3416cpp.CBlockHeader_destruct(blkHeaderDummy)
-    # aserti3416cpp.Params_destruct(params)
-    # for block in blocks:
-    #     aserti3416cpp.CBlockIndex_destruct(block)
+    for state in states[cpp_store_size:]:
+        aserti3416cpp.ChainStore_push_back(cpp_store, state.timestamp, state.bits)
+    cpp_store_size = len(states)
 
-    return res
+def next_bits_daa_cpp(msg, daa):
+    '''Any algorithm of the native registry (aserti3416cpp.DAA_names()).'''
+    sync_cpp_store(chain_work=True)
+    return aserti3416cpp.DAA_next_work_required(
+        cpp_store, daa, states[-1].height, cpp_params)
 
 
 def next_bits_aserti(msg, tau, mode=1, mo3=False):
@@ -490,6 +514,15 @@ Algos = {
         'tau': int(math.log(2) * IDEAL_BLOCK_TIME * 416),
         'mode': 3, 'mo3':True,
     }),
+
+    # Other algorithms, native only
+    'wtema-072' : Algo(next_bits_daa_cpp, {'daa': 'wtema-072'}),
+    'wtema-144' : Algo(next_bits_daa_cpp, {'daa': 'wtema-144'}),
+    'wtema-288' : Algo(next_bits_daa_cpp, {'daa': 'wtema-288'}),
+    'wtema-576' : Algo(next_bits_daa_cpp, {'daa': 'wtema-576'}),
+    'cw-144' : Algo(next_bits_daa_cpp, {'daa': 'cw-144'}),
+    'lwma-045' : Algo(next_bits_daa_cpp, {'daa': 'lwma-045'}),
+    'lwma-144' : Algo(next_bits_daa_cpp, {'daa': 'lwma-144'}),
 }
 
 Scenario = namedtuple('Scenario', 'next_fx, params, dr_hashrate, pump_144_threshold')
@@ -511,6 +544,7 @@ Scenarios = {
 def run_one_simul(print_it, returnstate=False, params=default_params):
     lock.acquire()
     states.clear()
+    reset_cpp_chain()
 
     try:
         # Initial state is afer 2020 steady prefix blocks
@@ -567,6 +601,16 @@ def run_one_simul(print_it, returnstate=False, params=default_params):
                    for n in range(len(simul) - 1)]
     return block_times
 
+def run_simuls_cpp(scenario_name, count, seed, params=default_params, threads=0,
+                   algo='aserti3-416-cpp'):
+    '''Runs count simulations of algo, any of aserti3416cpp.DAA_names(), in
+    native code, on all cores unless threads says otherwise. Run i draws from its own
+    (seed, i) random streams, so results do not depend on threads.
+    Returns the mean, stdev, median and max block time distributions across
+    runs as a dict of (min, max, mean, stdev, median) tuples.'''
+    return aserti3416cpp.RunSimulations(params, scenario_name, cpp_params,
+                                        seed, count, threads, algo)
+
 
 # def main():
 #     '''Outputs CSV data to stdout.   Final stats to stderr.'''
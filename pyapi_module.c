@@ -23,6 +23,8 @@ PyMethodDef NativeMethods[] = {
     {"CBlockIndex_set_nTime",      PyAPI_CBlockIndex_set_nTime, METH_VARARGS, ""},
     {"CBlockIndex_set_nBits",      PyAPI_CBlockIndex_set_nBits, METH_VARARGS, ""},
     {"CBlockIndex_set_pprev",      PyAPI_CBlockIndex_set_pprev, METH_VARARGS, ""},
+    {"CBlockIndex_link",           PyAPI_CBlockIndex_link, METH_VARARGS, ""},
+    {"CBlockIndex_GetAncestor",    PyAPI_CBlockIndex_GetAncestor, METH_VARARGS, ""},
     {"CBlockIndex_set_nChainWork", PyAPI_CBlockIndex_set_nChainWork, METH_VARARGS, ""},
 
     // class CBlockHeader --------------------------------------------------------
@@ -36,9 +38,56 @@ PyMethodDef NativeMethods[] = {
     // Parameters --------------------------------------------------------
     {"Params_GetDefaultMainnetConsensusParams",  PyAPI_Params_GetDefaultMainnetConsensusParams, METH_VARARGS, ""},
     {"Params_destruct",  PyAPI_Params_destruct, METH_VARARGS, ""},
+    {"Params_set_powLimit",  PyAPI_Params_set_powLimit, METH_VARARGS, ""},
+    {"Params_set_nDAAHalfLife",  PyAPI_Params_set_nDAAHalfLife, METH_VARARGS, ""},
+    {"Params_set_nPowTargetSpacing",  PyAPI_Params_set_nPowTargetSpacing, METH_VARARGS, ""},
+    {"Params_set_fPowAllowMinDifficultyBlocks",  PyAPI_Params_set_fPowAllowMinDifficultyBlocks, METH_VARARGS, ""},
 
     // GetNextASERTWorkRequired --------------------------------------------------------
     {"GetNextASERTWorkRequired",  PyAPI_GetNextASERTWorkRequired, METH_VARARGS, ""},
+    {"GetSuitableBlock",  PyAPI_GetSuitableBlock, METH_VARARGS, ""},
+    {"GetNextASERTMo3WorkRequired",  PyAPI_GetNextASERTMo3WorkRequired, METH_VARARGS, ""},
+    {"CalculateASERTBatch",  PyAPI_CalculateASERTBatch, METH_VARARGS, ""},
+    {"CalculateASERTBatch_into",  PyAPI_CalculateASERTBatch_into, METH_VARARGS, ""},
+
+    // class ASERTChain --------------------------------------------------------
+    {"ASERTChain_construct",          PyAPI_ASERTChain_construct, METH_VARARGS, ""},
+    {"ASERTChain_destruct",           PyAPI_ASERTChain_destruct, METH_VARARGS, ""},
+    {"ASERTChain_append",             PyAPI_ASERTChain_append, METH_VARARGS, ""},
+    {"ASERTChain_next_work_required", PyAPI_ASERTChain_next_work_required, METH_VARARGS, ""},
+
+    // class CChainStore --------------------------------------------------------
+    {"ChainStore_construct",                  PyAPI_ChainStore_construct, METH_VARARGS, ""},
+    {"ChainStore_destruct",                   PyAPI_ChainStore_destruct, METH_VARARGS, ""},
+    {"ChainStore_push_back",                  PyAPI_ChainStore_push_back, METH_VARARGS, ""},
+    {"ChainStore_append",                     PyAPI_ChainStore_append, METH_VARARGS, ""},
+    {"ChainStore_truncate",                   PyAPI_ChainStore_truncate, METH_VARARGS, ""},
+    {"ChainStore_get_tip_height",             PyAPI_ChainStore_get_tip_height, METH_VARARGS, ""},
+    {"ChainStore_next_work_required",         PyAPI_ChainStore_next_work_required, METH_VARARGS, ""},
+    {"ChainStore_get_suitable_height",        PyAPI_ChainStore_get_suitable_height, METH_VARARGS, ""},
+    {"ChainStore_next_work_required_mo3",     PyAPI_ChainStore_next_work_required_mo3, METH_VARARGS, ""},
+    {"ChainStore_next_work_required_range",   PyAPI_ChainStore_next_work_required_range, METH_VARARGS, ""},
+    {"ChainStore_next_work_required_range_into", PyAPI_ChainStore_next_work_required_range_into, METH_VARARGS, ""},
+    {"ChainStore_find_first_bits_mismatch",   PyAPI_ChainStore_find_first_bits_mismatch, METH_VARARGS, ""},
+    {"ChainStore_load_headers",               PyAPI_ChainStore_load_headers, METH_VARARGS, ""},
+    {"ChainStore_append_headers",             PyAPI_ChainStore_append_headers, METH_VARARGS, ""},
+    {"ChainStore_enable_chain_work",          PyAPI_ChainStore_enable_chain_work, METH_VARARGS, ""},
+    {"ChainStore_get_chain_work",             PyAPI_ChainStore_get_chain_work, METH_VARARGS, ""},
+
+    // Proof of work --------------------------------------------------------
+    {"GetBlockProof",                      PyAPI_GetBlockProof, METH_VARARGS, ""},
+    {"HeaderFile_find_first_invalid_pow",  PyAPI_HeaderFile_find_first_invalid_pow, METH_VARARGS, ""},
+    {"Headers_find_first_invalid_pow",     PyAPI_Headers_find_first_invalid_pow, METH_VARARGS, ""},
+    {"SHA256d_headers_into",               PyAPI_SHA256d_headers_into, METH_VARARGS, ""},
+
+    // Difficulty algorithms --------------------------------------------------------
+    {"DAA_names",                     PyAPI_DAA_names, METH_NOARGS, ""},
+    {"DAA_next_work_required",        PyAPI_DAA_next_work_required, METH_VARARGS, ""},
+    {"DAA_next_work_required_range",  PyAPI_DAA_next_work_required_range, METH_VARARGS, ""},
+    {"DAA_next_work_required_range_into",  PyAPI_DAA_next_work_required_range_into, METH_VARARGS, ""},
+
+    // Simulation --------------------------------------------------------
+    {"RunSimulations",  PyAPI_RunSimulations, METH_VARARGS, ""},
 
     {NULL, NULL, 0, NULL}        /* Sentinel */
 };
@@ -123,7 +123,7 @@ extensions = [
         # include_dirs=['kth/include'],
         # library_dirs=['kth/lib'],
 
-    	sources = ['aserti3-416.cpp',  'aserti3-416_capi.cpp', 'aserti3-416_pyapi.c', 'pyapi_module.c'],
+    	sources = ['aserti3-416.cpp',  'aserti3-416_simd.cpp',  'aserti3-416_random.cpp',  'aserti3-416_daa.cpp',  'aserti3-416_simul.cpp',  'aserti3-416_validation.cpp',  'aserti3-416_headers.cpp',  'aserti3-416_pow.cpp',  'aserti3-416_chainwork.cpp',  'aserti3-416_capi.cpp', 'aserti3-416_pyapi.c', 'pyapi_module.c'],
     ),
 ]
 
@@ -0,0 +1,189 @@
+import array
+import hashlib
+import os
+import random
+import tempfile
+import threading
+
+import aserti3416cpp
+
+# The buffer-protocol (_into) functions against their list versions, their
+# input errors, and the chain store under concurrent readers and a writer.
+
+def raises(exception, f, *args):
+    try:
+        f(*args)
+    except exception:
+        return True
+    return False
+
+params = aserti3416cpp.Params_GetDefaultMainnetConsensusParams()
+random.seed(1)
+n = 5000
+
+# CalculateASERTBatch
+time_diffs = [random.randrange(-10**7, 10**7) for _ in range(n)]
+height_diffs = [random.randrange(1, 10**5) for _ in range(n)]
+expected = aserti3416cpp.CalculateASERTBatch(0x1804dafe, time_diffs, height_diffs, params)
+out = array.array('I', bytes(4 * n))
+assert aserti3416cpp.CalculateASERTBatch_into(0x1804dafe, array.array('q', time_diffs),
+                                              memoryview(array.array('q', height_diffs)), params, out) is None
+assert list(out) == expected
+
+small = (array.array('q', time_diffs[:3]), array.array('q', height_diffs[:3]))
+assert raises(TypeError, aserti3416cpp.CalculateASERTBatch_into, 0x1804dafe,
+              array.array('i', time_diffs[:3]), small[1], params, array.array('I', [0] * 3))
+assert raises(TypeError, aserti3416cpp.CalculateASERTBatch_into, 0x1804dafe,
+              array.array('d', [0.0] * 3), small[1], params, array.array('I', [0] * 3))
+assert raises(TypeError, aserti3416cpp.CalculateASERTBatch_into, 0x1804dafe,
+              [1, 2, 3], small[1], params, array.array('I', [0] * 3))
+assert raises((TypeError, BufferError), aserti3416cpp.CalculateASERTBatch_into, 0x1804dafe,
+              *small, params, bytes(12))
+assert raises(ValueError, aserti3416cpp.CalculateASERTBatch_into, 0x1804dafe,
+              small[0], array.array('q', height_diffs[:2]), params, array.array('I', [0] * 3))
+assert raises(ValueError, aserti3416cpp.CalculateASERTBatch_into, 0x1804dafe,
+              *small, params, array.array('I', [0] * 2))
+assert raises(ValueError, aserti3416cpp.CalculateASERTBatch_into, 0,
+              *small, params, array.array('I', [0] * 3))
+assert raises(ValueError, aserti3416cpp.CalculateASERTBatch_into, 0x1804dafe,
+              small[0], array.array('q', [1, -1, 1]), params, array.array('I', [0] * 3))
+assert raises(ValueError, aserti3416cpp.CalculateASERTBatch, 0x1804dafe, [1], [-1], params)
+
+# ASERTChain
+chain = aserti3416cpp.ASERTChain_construct(params)
+assert raises(ValueError, aserti3416cpp.ASERTChain_next_work_required, chain)
+aserti3416cpp.ASERTChain_append(chain, 0, 1605447844, 0x1804dafe)
+aserti3416cpp.ASERTChain_append(chain, 1, 1605447844 + 600, 0x1804dafe)
+assert aserti3416cpp.ASERTChain_next_work_required(chain) == 0x1804dafe
+aserti3416cpp.ASERTChain_destruct(chain)
+
+# ChainStore_append and the range functions
+times = [1605447844 + 600 * i + random.randrange(-300, 300) for i in range(n)]
+bits = [0x1804dafe] * n
+for i in range(1, n):
+    bits[i] = random.choice([bits[i - 1], 0x18000000 | random.randrange(0x8000, 0x800000)])
+pushed = aserti3416cpp.ChainStore_construct(0, True)
+appended = aserti3416cpp.ChainStore_construct(0, True)
+for t, b in zip(times, bits):
+    aserti3416cpp.ChainStore_push_back(pushed, t, b)
+aserti3416cpp.ChainStore_append(appended, array.array('I', times[:100]), array.array('I', bits[:100]))
+aserti3416cpp.ChainStore_append(appended, array.array('I', times[100:]), array.array('I', bits[100:]), 0)
+assert aserti3416cpp.ChainStore_get_tip_height(appended) == n - 1
+assert all(aserti3416cpp.ChainStore_get_chain_work(pushed, h) == aserti3416cpp.ChainStore_get_chain_work(appended, h)
+           for h in range(0, n, 7))
+
+expected = aserti3416cpp.ChainStore_next_work_required_range(pushed, 0, 1, n - 2, params)
+out = array.array('I', bytes(4 * (n - 2)))
+aserti3416cpp.ChainStore_next_work_required_range_into(appended, 0, 1, params, out)
+assert list(out) == expected
+assert raises(IndexError, aserti3416cpp.ChainStore_next_work_required_range_into,
+              appended, 0, 1, params, array.array('I', bytes(4 * n)))
+assert raises(IndexError, aserti3416cpp.ChainStore_next_work_required_range,
+              appended, 0, 2**31 - 48, 100, params)
+assert raises(IndexError, aserti3416cpp.ChainStore_next_work_required_range,
+              appended, 0, 1, 2**62, params)
+assert raises(IndexError, aserti3416cpp.ChainStore_next_work_required_range_into,
+              appended, 0, 2**31 - 48, params, array.array('I', bytes(4 * 100)))
+assert len(aserti3416cpp.ChainStore_next_work_required_range(appended, 0, n - 1, 1, params)) == 1
+assert raises(IndexError, aserti3416cpp.ChainStore_next_work_required_range, appended, 0, n - 1, 2, params)
+
+for name in aserti3416cpp.DAA_names():
+    try:
+        expected = aserti3416cpp.DAA_next_work_required_range(appended, name, 3000, 1000, params)
+    except IndexError:
+        continue
+    out = array.array('I', bytes(4 * 1000))
+    aserti3416cpp.DAA_next_work_required_range_into(appended, name, 3000, params, out)
+    assert list(out) == expected, name
+assert raises(ValueError, aserti3416cpp.DAA_next_work_required_range_into,
+              appended, 'none', 3000, params, array.array('I', bytes(4)))
+assert raises(IndexError, aserti3416cpp.DAA_next_work_required_range,
+              appended, 'wtema-144', 2**31 - 48, 100, params)
+assert raises(IndexError, aserti3416cpp.DAA_next_work_required_range,
+              appended, 'wtema-144', 3000, 2**62, params)
+assert raises(IndexError, aserti3416cpp.DAA_next_work_required_range,
+              appended, 'wtema-144', n, 0, params)
+assert raises(IndexError, aserti3416cpp.DAA_next_work_required_range_into,
+              appended, 'wtema-144', 2**31 - 48, params, array.array('I', bytes(4 * 100)))
+assert len(aserti3416cpp.DAA_next_work_required_range(appended, 'wtema-144', n - 1, 1, params)) == 1
+
+# Headers
+genesis = bytes.fromhex(
+    '0100000000000000000000000000000000000000000000000000000000000000'
+    '000000003ba3edfd7a7b12b27ac72c3e67768f617fc81bc3888a51323a9fb8aa'
+    '4b1e5e4a29ab5f49ffff001d1dac2b7c')
+headers = bytearray(genesis * 37)
+headers[20 * 80 + 76] ^= 1
+assert aserti3416cpp.Headers_find_first_invalid_pow(headers, params) == 20
+assert aserti3416cpp.Headers_find_first_invalid_pow(genesis * 3, params) is None
+out = bytearray(32 * 37)
+aserti3416cpp.SHA256d_headers_into(memoryview(headers), out)
+assert all(out[32 * i:32 * i + 32] == hashlib.sha256(hashlib.sha256(headers[80 * i:80 * i + 80]).digest()).digest()
+           for i in range(37))
+assert out[:32][::-1].hex() == '000000000019d6689c085ae165831e934ff763ae46a2a6c172b3f1b60a8ce26f'
+assert raises((TypeError, BufferError), aserti3416cpp.SHA256d_headers_into, genesis, bytes(32))
+store = aserti3416cpp.ChainStore_construct(0, True)
+assert aserti3416cpp.ChainStore_append_headers(store, headers) == 37
+assert aserti3416cpp.ChainStore_get_chain_work(store, 36) == 37 * aserti3416cpp.GetBlockProof(0x1d00ffff)
+assert raises(ValueError, aserti3416cpp.ChainStore_append_headers, store, genesis[:79])
+
+# ChainStore_load_headers from a dump, an empty one, a truncated one and a
+# missing file
+with tempfile.TemporaryDirectory() as directory:
+    path = os.path.join(directory, 'headers.dat')
+    with open(path, 'wb') as f:
+        f.write(headers)
+    store = aserti3416cpp.ChainStore_construct(0, True)
+    assert aserti3416cpp.ChainStore_load_headers(store, path) == 37
+    assert aserti3416cpp.ChainStore_get_tip_height(store) == 36
+    assert aserti3416cpp.ChainStore_get_chain_work(store, 36) == 37 * aserti3416cpp.GetBlockProof(0x1d00ffff)
+    with open(path, 'wb') as f:
+        pass
+    assert aserti3416cpp.ChainStore_load_headers(store, path) == 0
+    with open(path, 'wb') as f:
+        f.write(headers[:-1])
+    assert raises(OSError, aserti3416cpp.ChainStore_load_headers, store, path)
+    assert raises(OSError, aserti3416cpp.ChainStore_load_headers, store, os.path.join(directory, 'missing.dat'))
+    assert aserti3416cpp.ChainStore_get_tip_height(store) == 36
+
+# ChainStore_truncate
+store = aserti3416cpp.ChainStore_construct(100)
+aserti3416cpp.ChainStore_append(store, array.array('I', times[:10]), array.array('I', bits[:10]))
+assert raises(IndexError, aserti3416cpp.ChainStore_truncate, store, 98)
+assert raises(IndexError, aserti3416cpp.ChainStore_truncate, store, -2**31)
+assert aserti3416cpp.ChainStore_get_tip_height(store) == 109
+aserti3416cpp.ChainStore_truncate(store, 104)
+assert aserti3416cpp.ChainStore_get_tip_height(store) == 104
+aserti3416cpp.ChainStore_truncate(store, 99)
+assert aserti3416cpp.ChainStore_get_tip_height(store) == 99
+
+# Readers against a writer appending and truncating the same store
+store = aserti3416cpp.ChainStore_construct(0, True)
+aserti3416cpp.ChainStore_append(store, array.array('I', times), array.array('I', bits))
+expected = aserti3416cpp.ChainStore_next_work_required_range(store, 0, 1, 1000, params)
+failures = []
+done = threading.Event()
+
+def read():
+    try:
+        while not done.is_set():
+            out = array.array('I', bytes(4 * 1000))
+            aserti3416cpp.ChainStore_next_work_required_range_into(store, 0, 1, params, out)
+            if list(out) != expected:
+                failures.append('range')
+    except Exception as e:
+        failures.append(repr(e))
+
+readers = [threading.Thread(target=read) for _ in range(3)]
+for reader in readers:
+    reader.start()
+for _ in range(200):
+    aserti3416cpp.ChainStore_append(store, array.array('I', times[:500]), array.array('I', bits[:500]))
+    aserti3416cpp.ChainStore_truncate(store, n - 1)
+done.set()
+for reader in readers:
+    reader.join()
+assert not failures, failures
+assert aserti3416cpp.ChainStore_get_tip_height(store) == n - 1
+
+print('ok')